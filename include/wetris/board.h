@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#pragma once
+
+#include "piece.h"
+#include "tile.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BOARD_WIDTH 12  /* walls are counted too */
+#define BOARD_HEIGHT 21 /* the bottom wall is also counted */
+
+/*
+ * Every row of the occupancy plane is a single word, bit x corresponds to the
+ * column x. Walls and the bits past the right wall are always set, so a row is
+ * full when all of its bits are set.
+ */
+#define BOARD_FULL_ROW 0xffffu
+#define BOARD_EMPTY_ROW                                                        \
+    ((uint16_t)(BOARD_FULL_ROW & ~((1u << (BOARD_WIDTH - 1)) - 2u)))
+#define BOARD_INNER_MASK ((uint16_t)(BOARD_FULL_ROW ^ BOARD_EMPTY_ROW))
+
+/*
+ * When testing collisions a row is widened to 32 bits with 4 solid columns on
+ * the left, so pieces poking out of the left wall need no special casing.
+ */
+#define BOARD_GUARD 4
+#define BOARD_GUARD_MASK 0xfff0000fu
+
+/* Colors take 3 bits per inner column, 0 means an empty cell. */
+#define BOARD_COLOR_BITS 3
+#define BOARD_COLOR_MASK 0x7u
+
+struct Board {
+    uint16_t rows[BOARD_HEIGHT];
+    uint32_t colors[BOARD_HEIGHT - 1]; /* the bottom wall has no colors */
+    /* Number of cells between the floor and the surface of every column. */
+    uint8_t heights[BOARD_WIDTH];
+    /* Zobrist hash of the occupancy plane (see zobrist.h), kept up to date by
+     * board_put() and board_clear_rows(). */
+    uint64_t hash;
+};
+
+/* Returns the piece in the position where new pieces appear. */
+struct Piece board_spawn_piece(enum PieceId id);
+void board_clear(struct Board *self);
+void board_put(
+    struct Board *self, uint16_t mask, int x, int y, enum TileId tile
+);
+/* Deletes all full rows at once and returns how many there were. */
+int board_clear_rows(struct Board *self);
+/*
+ * Pushes all rows up and fills the bottom ones with garbage, full except for
+ * the hole column (0 is the leftmost one) and without colors. Returns how many
+ * rows with blocks were pushed out over the top.
+ */
+int board_add_garbage(struct Board *self, int rows, int hole);
+/* Bit y is set for every full row. */
+uint32_t board_full_rows(const struct Board *self);
+/* Needed only after the rows were modified directly. */
+void board_update_heights(struct Board *self);
+void board_update_hash(struct Board *self);
+/* Returns the first occupied row below y in the column x. */
+int board_next_occupied(const struct Board *self, int x, int y);
+/* Returns how many rows the piece can fall, the piece is expected to fit. */
+int board_drop_distance(const struct Board *self, const struct Piece *piece);
+enum TileId board_tile(const struct Board *self, int x, int y);
+
+/*
+ * Rotates the piece into the given rotation, trying the kick offsets if it
+ * doesn't fit in place. The piece isn't touched when every test fails.
+ */
+bool board_rotate_piece(
+    const struct Board *self, struct Piece *piece, int rotation
+);
+
+static inline bool board_fits(
+    const struct Board *self, uint16_t mask, int x, int y
+) {
+    if (x < -BOARD_GUARD || x > 32 - BOARD_GUARD - PIECE_WIDTH) {
+        return false;
+    }
+
+    uint32_t bits = mask;
+
+    for (int row_y = y; bits != 0; ++row_y, bits >>= PIECE_WIDTH) {
+        uint32_t row_bits = bits & 0xfu;
+
+        if (!row_bits) {
+            continue;
+        }
+
+        if (row_y < 0 || row_y >= BOARD_HEIGHT) {
+            return false;
+        }
+
+        uint32_t line = ((uint32_t)self->rows[row_y] << BOARD_GUARD) |
+                        BOARD_GUARD_MASK;
+
+        if (line & (row_bits << (x + BOARD_GUARD))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static inline bool
+board_piece_fits(const struct Board *self, const struct Piece *piece) {
+    return board_fits(self, piece_mask(piece), piece->pos.x, piece->pos.y);
+}
+
+static inline bool board_occupied(const struct Board *self, int x, int y) {
+    return (self->rows[y] >> x) & 1u;
+}
+
+/* Returns the topmost occupied row of the column x. */
+static inline int board_top(const struct Board *self, int x) {
+    return BOARD_HEIGHT - 1 - self->heights[x];
+}
+
+static inline bool board_row_full(const struct Board *self, int y) {
+    return self->rows[y] == BOARD_FULL_ROW;
+}
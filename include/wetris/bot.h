@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#pragma once
+
+/*
+ * The bot enumerates every final placement of the current piece that can be
+ * reached with the same moves, kicks and collisions as the player has, scores
+ * each one with a weighted sum of board features and looks one piece ahead
+ * using the next piece.
+ */
+
+#include "board.h"
+#include "features.h"
+#include "piece.h"
+#include "tetrion.h"
+#include "trans_table.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct Planner;
+
+#define BOT_MAX_INPUTS 64
+#define BOT_MAX_LANDINGS 256
+
+/* Every position a piece can take while still having a block on the board */
+#define BOT_SEARCH_MIN_X (-4)
+#define BOT_SEARCH_MIN_Y (-4)
+#define BOT_SEARCH_WIDTH 16
+#define BOT_SEARCH_HEIGHT 24
+#define BOT_SEARCH_STATES                                                      \
+    (BOT_SEARCH_WIDTH * BOT_SEARCH_HEIGHT * PIECE_ROTATIONS)
+
+/* Weights of the board features (see features.h) and of the cleared rows. */
+struct BotWeights {
+    double holes;
+    double height; /* aggregate height */
+    double bumpiness;
+    double lines;
+    double row_transitions;
+    double column_transitions;
+    double wells;
+};
+
+/*
+ * The inputs are tetrion actions applied in order. The only exception is
+ * TETRION_ACTION_SOFT_DROP_ON, which stands for letting the piece fall by one
+ * row (it's needed to reach tucks and spins). The last input is always
+ * TETRION_ACTION_HARD_DROP.
+ */
+struct BotPlacement {
+    struct Piece piece; /* where the piece lands */
+    int lines;
+    double score;
+    enum TetrionAction inputs[BOT_MAX_INPUTS];
+    int input_count;
+};
+
+struct BotLanding {
+    struct Piece piece;
+    int state;    /* the search state the piece is dropped from */
+    uint32_t key; /* the cells covered by the piece */
+};
+
+/*
+ * The distinct final positions of a piece together with the breadth-first
+ * search over the piece states that found them. Rotations of a symmetric piece
+ * covering the same cells count once.
+ */
+struct BotLandings {
+    uint8_t visited[BOT_SEARCH_STATES];
+    int16_t parent[BOT_SEARCH_STATES];
+    uint8_t input[BOT_SEARCH_STATES];  /* the input leading to the state */
+    uint8_t repeat[BOT_SEARCH_STATES]; /* and how many times it's applied */
+    uint16_t queue[BOT_SEARCH_STATES];
+    int queue_size;
+    struct BotLanding landings[BOT_MAX_LANDINGS];
+    int count;
+};
+
+/* Follows the placements of the bot while advancing a tetrion. */
+struct BotPlayer {
+    struct BotWeights weights;
+    struct TransTable *table; /* optional, NULL after init */
+    struct Planner *planner;  /* used instead of bot_search() if not NULL */
+    struct BotPlacement plan;
+    int next_input; /* -1 when a new plan is needed */
+    bool falling;   /* waiting for the piece to fall by one row */
+    int fall_y;
+};
+
+struct BotWeights bot_weights_default(void);
+/*
+ * Finds the best placement of the current piece. Returns false when the
+ * tetrion isn't in the normal state or the piece cannot be placed at all.
+ *
+ * The look-ahead scores are cached in the table when one is given. It may be
+ * shared by searches running in parallel, even ones with different weights.
+ */
+bool bot_search(
+    const struct Tetrion *tetrion, const struct BotWeights *weights,
+    struct TransTable *table, struct BotPlacement *best
+);
+/* Finds every landing of the piece reachable with the player's moves. */
+void bot_landings_find(
+    struct BotLandings *self, const struct Board *board,
+    const struct Piece *piece
+);
+/* Returns false when the landing takes more than BOT_MAX_INPUTS inputs. */
+bool bot_landings_inputs(
+    const struct BotLandings *self, int landing, struct BotPlacement *placement
+);
+/* Locks the piece and deletes the full rows, returns how many there were. */
+int bot_place(struct Board *board, const struct Piece *piece);
+double bot_evaluate(
+    const struct BoardFeatures *features, int lines,
+    const struct BotWeights *weights
+);
+/* Keeps the scores of different weights apart in a transposition table. */
+uint64_t bot_weights_key(const struct BotWeights *weights);
+/*
+ * Scores the best landing of the next piece on the board, -DBL_MAX if it has
+ * none, leaving out the rows deleted before. The score is cached in the table
+ * when one is given, salted with bot_weights_key() of the weights.
+ */
+double bot_look_ahead(
+    struct BotLandings *scratch, const struct Board *board,
+    const struct Piece *next, const struct BotWeights *weights,
+    struct TransTable *table, uint64_t salt
+);
+
+void bot_player_init(struct BotPlayer *self, const struct BotWeights *weights);
+/* Applies the inputs due now and advances the tetrion by one tick. */
+void bot_player_tick(struct BotPlayer *self, struct Tetrion *tetrion);
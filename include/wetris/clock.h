@@ -0,0 +1,16 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * Nanoseconds of a monotonic clock, for measuring time spans (budgets,
+ * benchmarks). Unlike the wall clock it never jumps, only differences of its
+ * readings mean something.
+ */
+uint64_t clock_ns(void);
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#pragma once
+
+/*
+ * A batch of games stepped in lockstep, e.g. for training agents. Instead of
+ * a tetrion per game, every part of the state lives in its own contiguous
+ * array indexed by the game. A step applies one action to every game and then
+ * lets every piece fall by one row, there are no timers. Rows are cleared right
+ * away, like in a tetrion without clear delay.
+ */
+
+#include "board.h"
+#include "piece.h"
+#include "randomizer.h"
+#include "tetrion.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+enum EnvAction {
+    ENV_ACTION_NONE,
+    ENV_ACTION_MOVE_LEFT,
+    ENV_ACTION_MOVE_RIGHT,
+    ENV_ACTION_ROTATE,
+    ENV_ACTION_ROTATE_CNT,
+    ENV_ACTION_SOFT_DROP, /* an extra row down */
+    ENV_ACTION_HARD_DROP,
+    TOTAL_ENV_ACTIONS
+};
+
+struct EnvBatch {
+    int size;
+    enum RandomizerKind randomizer;
+    struct TetrionScoring scoring;
+
+    struct Board *boards;
+    struct Piece *pieces;
+    struct Piece *next_pieces;
+    int32_t *scores;
+    uint32_t *steps; /* since the last reset */
+    struct Randomizer *randomizers;
+};
+
+/*
+ * Only the seed (of the whole batch), the randomizer and the scoring of the
+ * configuration are used.
+ */
+bool env_batch_init(
+    struct EnvBatch *self, int size, const struct TetrionConfig *config
+);
+void env_batch_deinit(struct EnvBatch *self);
+/*
+ * Applies actions[i] (an EnvAction) to the game i and advances every game by
+ * one row. Rewards are the score gained during the step, games that are over
+ * are marked done and start over right away.
+ */
+void env_batch_step(
+    struct EnvBatch *self, const uint8_t *actions, int32_t *rewards,
+    bool *done
+);
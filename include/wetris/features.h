@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#pragma once
+
+/*
+ * Features of a board used to judge placements. They're computed in a single
+ * pass over the rows, several rows at once with SSE2 or AVX2 when the compiler
+ * targets them, with a portable fallback otherwise.
+ */
+
+#include "board.h"
+
+#include <stdint.h>
+
+#define FEATURES_COLUMNS (BOARD_WIDTH - 2) /* inner columns only */
+
+struct BoardFeatures {
+    uint8_t heights[FEATURES_COLUMNS];
+    int max_height;
+    int aggregate_height;
+    int bumpiness; /* sum of the height differences of adjacent columns */
+    int holes;     /* empty cells below the surface */
+    /* Changes between an empty and an occupied cell (walls count as
+     * occupied) along the rows and along the columns. */
+    int row_transitions;
+    int column_transitions;
+    /* Every well cell (empty, with both neighbours occupied) counts the well
+     * cells above it in a row, so a well of depth d is worth d(d+1)/2. */
+    int wells;
+};
+
+/* Name of the kernel compiled in, e.g. for benchmarks. */
+const char *features_kernel(void);
+void features_compute(
+    const struct Board *board, struct BoardFeatures *features
+);
+/*
+ * A convenience wrapper computing the boards one by one, the kernels are
+ * vectorized over the rows of a single board, not across boards.
+ */
+void features_compute_batch(
+    const struct Board *boards, int count, struct BoardFeatures *features
+);
@@ -29,15 +29,14 @@ bool font_open_ttf(
     float point_size
 );
 void font_close(struct Font *self);
-void font_render_char(
-    const struct Font *self, char ch, int x, int y, struct SDL_Color fg
-);
-void font_render_str(
-    const struct Font *self, const char *text, int x, int y, struct SDL_Color fg
-);
-void font_render_str_n(
+/*
+ * Writes a quad of 4 vertices for every visible glyph of the text, in the
+ * given color, and returns their count. vertices must hold 4 * len of them.
+ * Meant to be drawn from glyph_atlas with SDL_RenderGeometry().
+ */
+int font_build_str_n(
     const struct Font *self, const char *text, size_t len, int x, int y,
-    struct SDL_Color fg
+    struct SDL_Color fg, SDL_Vertex *vertices
 );
 void font_measure(const struct Font *self, const char *text, int *w, int *h);
 void font_measure_n(
@@ -8,8 +8,12 @@
 
 #include "font_store.h"
 #include "input.h"
+#include "netplay.h"
+#include "replay.h"
 #include "sfx_store.h"
 #include "tetrion.h"
+#include "tetrion_view.h"
+#include "tileset.h"
 #include "ui.h"
 
 #include <SDL3/SDL.h>
@@ -18,14 +22,30 @@
 #include <stdbool.h>
 
 #define DEFAULT_FPS 60
+#define MAX_CATCH_UP 250 /* ms of the game simulated in one frame at most */
+#define IDLE_WAIT 1000   /* ms slept at most while nothing can change */
 #define TETRION_PADDING_LEFT (TILE_WIDTH * 3)
 #define TETRION_PADDING_RIGHT (TILE_WIDTH * 10)
 #define WINDOW_WIDTH                                                           \
     (TETRION_PADDING_LEFT + TETRION_PADDING_RIGHT + TETRION_WIDTH * TILE_WIDTH)
 #define WINDOW_HEIGHT (TILE_HEIGHT * (TETRION_HEIGHT + 4))
+/* In versus the board of the opponent is shown on the left */
+#define VERSUS_EXTRA_WIDTH (TETRION_PADDING_LEFT + TETRION_WIDTH * TILE_WIDTH)
 
 enum GameState { GAME_RUNNING, GAME_PAUSED, GAME_QUIT };
 
+struct GameOptions {
+    const char *record_path; /* NULL if the game isn't recorded */
+    const char *replay_path; /* NULL if the game is played from the keyboard */
+    int preview;             /* number of upcoming pieces shown */
+
+    /* Versus over the network, host_port is 0 and join_address NULL
+     * otherwise */
+    uint16_t host_port;
+    const char *join_address; /* HOST:PORT */
+    struct NetplayLink link;  /* simulated lag and loss for testing */
+};
+
 struct Game {
     int width;
     int height;
@@ -34,16 +54,31 @@ struct Game {
     struct SDL_Texture *background;
     struct UiState ui;
     struct TileSet tileset;
+    struct TileBatch tile_batch;
+    /* The local well first, then the one of the opponent in versus */
+    struct TetrionView views[VERSUS_PLAYERS];
     struct SfxStore sfx_store;
     struct FontStore font_store;
     struct InputState input;
 
     enum GameState state;
+    bool dirty; /* the scene changed since the last frame was rendered */
     struct Tetrion tetrion;
+    Uint64 tick_acc; /* ns not yet simulated */
+
+    const char *record_path;
+    bool replaying;
+    struct Replay replay;
+    struct ReplayPlayer player;
+
+    struct Netplay *netplay; /* NULL unless playing versus */
+    uint8_t versus_input;    /* the actions of the next frame */
 };
 
 struct Game *game_alloc(void);
 void game_free(struct Game *self);
-bool game_init(struct Game *self);
+bool game_init(struct Game *self, const struct GameOptions *options);
 void game_deinit(struct Game *self);
 void game_run(struct Game *self);
+/* The tetrion of the local player, also in versus. */
+struct Tetrion *game_tetrion(struct Game *self);
@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#pragma once
+
+/* A thin wrapper of non-blocking IPv4 UDP sockets. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct NetAddress {
+    uint32_t host; /* in host byte order */
+    uint16_t port;
+};
+
+struct NetSocket {
+    intptr_t handle;
+};
+
+/* Binds a socket to the given port on all interfaces, 0 picks any port. */
+bool net_socket_open(struct NetSocket *self, uint16_t port);
+void net_socket_close(struct NetSocket *self);
+bool net_send(
+    struct NetSocket *self, const struct NetAddress *to, const void *data,
+    size_t size
+);
+/* Returns the size of the received datagram, or -1 if there's none. */
+int net_receive(
+    struct NetSocket *self, struct NetAddress *from, void *buffer, size_t size
+);
+/* Parses HOST:PORT, where HOST is a dotted IPv4 address or "localhost". */
+bool net_parse_address(const char *text, struct NetAddress *address);
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#pragma once
+
+/*
+ * A versus match against a peer over UDP. The host waits for a HELLO, answers
+ * with the seed of the match and both sides then send every frame all their
+ * inputs the peer hasn't acknowledged yet, so a lost packet is made up for by
+ * the next one. The match itself runs ahead through rollback (see rollback.h).
+ */
+
+#include "net.h"
+#include "rng.h"
+#include "rollback.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define NETPLAY_DEFAULT_PORT 7370
+#define NETPLAY_MAX_PACKET 128
+#define NETPLAY_MAX_DELAYED 256
+
+enum NetplayState {
+    NETPLAY_STATE_CONNECTING,
+    NETPLAY_STATE_PLAYING,
+};
+
+/* A bad link simulated on the sending side, for testing. */
+struct NetplayLink {
+    int latency; /* frames */
+    int jitter;  /* up to this many frames are added at random */
+    int loss;    /* percent of the packets dropped */
+};
+
+struct NetplayPacket {
+    uint64_t due; /* the frame it's sent at */
+    size_t size;
+    uint8_t data[NETPLAY_MAX_PACKET];
+};
+
+struct Netplay {
+    struct NetSocket socket;
+    struct NetAddress peer;
+    bool host;
+    enum NetplayState state;
+    struct Rollback rollback;
+
+    struct NetplayLink link;
+    struct Rng link_rng;
+    struct NetplayPacket delayed[NETPLAY_MAX_DELAYED];
+    int delayed_count;
+    uint64_t clock; /* calls of netplay_update() */
+
+    /* Statistics */
+    uint64_t sent;
+    uint64_t dropped; /* by the simulated link */
+    uint64_t received;
+};
+
+/* link may be NULL for a link as good as the network. */
+bool netplay_host(
+    struct Netplay *self, uint16_t port, uint64_t seed,
+    const struct NetplayLink *link
+);
+bool netplay_join(
+    struct Netplay *self, const struct NetAddress *host,
+    const struct NetplayLink *link
+);
+void netplay_deinit(struct Netplay *self);
+/*
+ * Exchanges the packets and, given the local input, tries to advance the match
+ * by a frame. Meant to be called once per frame, with NULL while the match
+ * mustn't advance. Returns whether it advanced.
+ */
+bool netplay_update(struct Netplay *self, const uint8_t *input);
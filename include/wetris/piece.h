@@ -6,8 +6,11 @@
 
 #pragma once
 
-#include "tileset.h"
-#include <SDL3/SDL.h>
+#include "point.h"
+#include "tile.h"
+
+#include <stdbool.h>
+#include <stdint.h>
 
 #define PIECE_WIDTH 4
 #define PIECE_HEIGHT 4
@@ -80,22 +83,54 @@ enum PieceId {
     TOTAL_PIECES
 };
 
+#define PIECE_ROTATIONS 4
+#define PIECE_KICK_TESTS 5
+
+/*
+ * A piece is just its kind, rotation and position, the shape comes from
+ * g_piece_masks. Bit (y * PIECE_WIDTH + x) of a mask is set for every block.
+ */
 struct Piece {
     enum PieceId id;
-    int prev_rotation;
     int rotation;
-    enum TileId tile;
-    bool tiles[PIECE_HEIGHT][PIECE_WIDTH];
-    enum TileId tilemap[PIECE_HEIGHT][PIECE_WIDTH];
-    struct SDL_Point pos;
-    struct SDL_Point *kick_offs;
+    struct Point pos;
 };
 
+/* y points down, like everywhere else. */
+struct KickOff {
+    int8_t x;
+    int8_t y;
+};
+
+extern const uint16_t g_piece_masks[TOTAL_PIECES][PIECE_ROTATIONS];
+extern const struct KickOff g_kick_offs[TOTAL_PIECES][PIECE_ROTATIONS]
+                                       [PIECE_ROTATIONS][PIECE_KICK_TESTS];
+
 struct Piece piece_new(enum PieceId id);
-void piece_rotate_90(struct Piece *self);
-void piece_rotate_90_cnt(struct Piece *self);
-struct SDL_Point piece_get_kick_off(struct Piece *self, int idx);
-void piece_render(
-    struct Piece *self, struct SDL_Renderer *renderer, struct TileSet *tileset,
-    struct SDL_Point pos
-);
+
+static inline uint16_t piece_mask(const struct Piece *self) {
+    return g_piece_masks[self->id][self->rotation];
+}
+
+static inline bool piece_has_block(const struct Piece *self, int x, int y) {
+    return (piece_mask(self) >> (y * PIECE_WIDTH + x)) & 1u;
+}
+
+/* Tiles of the pieces follow the order of PieceId. */
+static inline enum TileId piece_tile(enum PieceId id) {
+    return (enum TileId)(TILE_RED + (int)id);
+}
+
+/* Tests to try when rotating a piece of the given kind from -> to. */
+static inline const struct KickOff *
+piece_kick_offs(enum PieceId id, int from, int to) {
+    return g_kick_offs[id][from][to];
+}
+
+static inline int piece_rotation_cw(int rotation) {
+    return (rotation + 1) % PIECE_ROTATIONS;
+}
+
+static inline int piece_rotation_cnt(int rotation) {
+    return (rotation + PIECE_ROTATIONS - 1) % PIECE_ROTATIONS;
+}
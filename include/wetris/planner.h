@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#pragma once
+
+/*
+ * A beam search over the current piece and the preview. Every depth places the
+ * next known piece on each board kept by the previous depth and keeps only the
+ * best boards, so the cost grows linearly with the depth. The boards of a depth
+ * are expanded in parallel on a pool, and the search stops early, with the
+ * result of the last complete depth, when its time budget runs out.
+ *
+ * With a transposition table the scores of the boards are cached, and so are
+ * the best landings of the last depth, which are shared with the greedy bot.
+ */
+
+#include "bot.h"
+#include "pool.h"
+#include "tetrion.h"
+#include "trans_table.h"
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PLANNER_MAX_DEPTH (1 + TETRION_MAX_PREVIEW)
+
+struct PlannerConfig {
+    struct BotWeights weights;
+    int beam_width; /* boards kept at every depth */
+    int depth;      /* pieces placed, limited by the preview of the tetrion */
+    uint64_t budget; /* ns per search, 0 for no limit */
+};
+
+struct PlannerNode {
+    struct Board board;
+    double score;
+    int lines; /* rows deleted on the way to the board */
+    int root;  /* the landing of the current piece leading here */
+};
+
+struct Planner {
+    struct PlannerConfig config;
+    struct Pool *pool;
+    struct TransTable *table; /* optional, NULL after init */
+    uint64_t salt;            /* bot_weights_key() of the weights */
+    struct BotLandings *scratch; /* one per worker */
+    struct BotLandings root;
+
+    struct PlannerNode *beam;
+    int beam_size;
+    /* BOT_MAX_LANDINGS slots for the children of every beam node */
+    struct PlannerNode *children;
+    int *child_counts;
+    struct PlannerRank *ranks;
+
+    struct Piece piece; /* placed at the current depth */
+    bool last;          /* only the best child of every board is needed */
+    uint64_t deadline;  /* ns, 0 for none */
+    _Atomic bool expired;
+
+    uint64_t searches;
+    uint64_t depth_total; /* depths completed over all searches */
+};
+
+struct PlannerConfig planner_config_default(void);
+/* The pool must outlive the planner and must not be running anything else. */
+bool planner_init(
+    struct Planner *self, struct Pool *pool, const struct PlannerConfig *config
+);
+void planner_deinit(struct Planner *self);
+/*
+ * Finds the placement of the current piece leading to the best board after
+ * the whole depth. Returns false when the tetrion isn't in the normal state
+ * or the piece cannot be placed at all.
+ */
+bool planner_search(
+    struct Planner *self, const struct Tetrion *tetrion,
+    struct BotPlacement *best
+);
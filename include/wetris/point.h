@@ -0,0 +1,12 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#pragma once
+
+struct Point {
+    int x;
+    int y;
+};
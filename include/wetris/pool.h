@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#pragma once
+
+/*
+ * A pool of worker threads running a job over a range of indices. Every worker
+ * starts with an equal share of the range and steals half of the remaining
+ * share of another worker once it runs out, so uneven jobs still keep every
+ * core busy.
+ */
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <threads.h>
+
+/* Called for every index, worker is in [0, pool size) */
+typedef void (*PoolJob)(void *ctx, int index, int worker);
+
+struct PoolWorker {
+    struct Pool *pool;
+    int id;
+    thrd_t thread;
+    /* The indices left to this worker, begin in the low half, end in the high
+     * half, so both can be updated with a single CAS. */
+    _Alignas(64) _Atomic uint64_t range;
+};
+
+struct Pool {
+    int size;
+    struct PoolWorker *workers;
+
+    mtx_t lock;
+    cnd_t wake;
+    cnd_t idle;
+    uint64_t generation; /* bumped by every run */
+    int running;         /* workers still busy with the current run */
+    bool quit;
+
+    PoolJob job;
+    void *ctx;
+};
+
+/* Spawns the given number of workers, 0 means one per processor. */
+bool pool_init(struct Pool *self, int size);
+void pool_deinit(struct Pool *self);
+/* Calls the job for every index in [0, count) and waits for all of them. */
+void pool_run(struct Pool *self, int count, PoolJob job, void *ctx);
+int pool_cpu_count(void);
@@ -0,0 +1,31 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#pragma once
+
+#include "piece.h"
+#include "rng.h"
+
+#include <stdint.h>
+
+enum RandomizerKind {
+    /* Every piece is picked independently. */
+    RANDOMIZER_RANDOM,
+    /* All 7 pieces are shuffled and dealt out before the next shuffle. */
+    RANDOMIZER_BAG,
+};
+
+struct Randomizer {
+    struct Rng rng;
+    enum RandomizerKind kind;
+    uint8_t bag[TOTAL_PIECES];
+    uint8_t bag_left;
+};
+
+void randomizer_init(
+    struct Randomizer *self, enum RandomizerKind kind, uint64_t seed
+);
+enum PieceId randomizer_next(struct Randomizer *self);
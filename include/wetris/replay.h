@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#pragma once
+
+/*
+ * A replay is the configuration of a game (including the seed) and a stream of
+ * actions stamped with the tick they were applied at. Since the rules are
+ * deterministic and advance in fixed ticks, applying the same actions at the
+ * same ticks reproduces the game exactly.
+ *
+ * Saved replays also carry keyframes, snapshots of the game taken every few
+ * seconds, and an index of them at the end of the file, so a player can seek
+ * to any tick by restoring a keyframe and playing at most one interval. All
+ * fields are little-endian at fixed offsets and loaded replays are read in
+ * place, straight from the memory mapped file where possible.
+ */
+
+#include "tetrion.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define REPLAY_MAGIC "WTRP"
+#define REPLAY_VERSION 3
+#define REPLAY_KEYFRAME_INTERVAL 5 /* s */
+
+struct Replay {
+    struct TetrionConfig config;
+    uint64_t duration; /* ticks */
+    int rules_version; /* TETRION_RULES_VERSION of the recording */
+
+    /* Entries are varints of (time delta << 3 | action). */
+    const uint8_t *actions;
+    size_t size;
+
+    /* Only used while recording */
+    uint8_t *buffer;
+    size_t capacity;
+    uint64_t last_time;
+
+    /* Only used by loaded replays, keyframes come from replay_save() */
+    const uint8_t *file;
+    size_t file_size;
+    bool mapped; /* otherwise the file is read into memory */
+    const uint8_t *index;
+    uint32_t keyframe_count;
+};
+
+struct ReplayPlayer {
+    const struct Replay *replay;
+    size_t pos;
+    size_t entry_pos;   /* where the next action starts */
+    uint64_t base_time; /* time of the action before it */
+    uint64_t time;      /* time of the next action */
+    enum TetrionAction action;
+    bool done;
+};
+
+void replay_init(struct Replay *self, const struct TetrionConfig *config);
+void replay_deinit(struct Replay *self);
+bool replay_record(
+    struct Replay *self, uint64_t time, enum TetrionAction action
+);
+void replay_finish(struct Replay *self, uint64_t time);
+/*
+ * Plays the replay once to build the keyframes while saving it. Replays
+ * recorded with other rules than the current ones are saved without them.
+ */
+bool replay_save(const struct Replay *self, const char *path);
+/* Loads the current version and the older ones (without keyframes). */
+bool replay_load(struct Replay *self, const char *path);
+
+void replay_player_init(struct ReplayPlayer *self, const struct Replay *replay);
+/* Advances the tetrion to the given tick, applying the recorded actions. */
+void replay_player_advance(
+    struct ReplayPlayer *self, struct Tetrion *tetrion, uint64_t time
+);
+/*
+ * Moves the tetrion to the given tick, backwards too. The tetrion must have
+ * been initialized with the configuration of the replay. Without a usable
+ * keyframe (old replays, other rules or another preview length) the game is
+ * played from the start or from where the tetrion is.
+ */
+void replay_player_seek(
+    struct ReplayPlayer *self, struct Tetrion *tetrion, uint64_t time
+);
@@ -0,0 +1,23 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/* xoshiro128** by David Blackman and Sebastiano Vigna. */
+struct Rng {
+    uint32_t s[4];
+};
+
+void rng_seed(struct Rng *self, uint64_t seed);
+uint32_t rng_next(struct Rng *self);
+uint64_t rng_next64(struct Rng *self);
+
+/* Returns a number in [0, n). */
+static inline uint32_t rng_range(struct Rng *self, uint32_t n) {
+    return (uint32_t)(((uint64_t)rng_next(self) * n) >> 32);
+}
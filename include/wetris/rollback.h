@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#pragma once
+
+/*
+ * Keeps a versus match going without waiting for the inputs of the remote
+ * player. Missing remote inputs are predicted to be empty and the match is
+ * snapshotted before every frame; once the real inputs arrive and differ, the
+ * match is restored to the first mispredicted frame and simulated again up to
+ * the present. Sending and receiving the inputs is left to the caller (see
+ * netplay.h).
+ */
+
+#include "versus.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* How far the present may run ahead of the last known remote input. */
+#define ROLLBACK_MAX_FRAMES 8
+/* Frames of inputs and snapshots kept, a power of two. */
+#define ROLLBACK_HISTORY 64
+
+struct Rollback {
+    struct Versus versus;
+    int local; /* the index of the local player */
+
+    /* Frame f is kept at f % ROLLBACK_HISTORY */
+    uint8_t local_inputs[ROLLBACK_HISTORY];
+    uint8_t remote_inputs[ROLLBACK_HISTORY];
+    struct VersusSnapshot snapshots[ROLLBACK_HISTORY]; /* before each frame */
+
+    uint64_t remote_frames;   /* remote inputs are known for frames below */
+    uint64_t acked;           /* the peer knows local inputs for frames below */
+    uint64_t mispredicted;    /* the first wrong frame, UINT64_MAX if none */
+
+    /* Statistics */
+    uint64_t rollbacks;
+    uint64_t resimulated; /* frames */
+    int max_depth;        /* frames resimulated by a single rollback */
+    uint64_t stalls;      /* refused advances */
+    uint64_t rollback_ns; /* spent restoring and resimulating */
+    uint64_t max_rollback_ns;
+};
+
+void rollback_init(struct Rollback *self, uint64_t seed, int local);
+/*
+ * Takes the remote inputs of the frames [first, first + count). Frames already
+ * known are skipped, so every packet can repeat the inputs not acknowledged
+ * yet. Inputs after a gap are dropped until the gap is filled.
+ */
+void rollback_add_remote(
+    struct Rollback *self, uint64_t first, const uint8_t *inputs, int count
+);
+/* The peer has received the local inputs for all frames before the given. */
+void rollback_ack(struct Rollback *self, uint64_t frames);
+/*
+ * Corrects the present after mispredictions, if there were any. Done by
+ * rollback_advance() too.
+ */
+void rollback_resimulate(struct Rollback *self);
+/*
+ * Runs the next frame with the given local input. Returns false when the
+ * present is too far ahead of the peer, the input has to be given again later.
+ */
+bool rollback_advance(struct Rollback *self, uint8_t input);
+/*
+ * Copies the local inputs not acknowledged by the peer, at most max of them,
+ * and returns their count. first is set to the frame of the first one.
+ */
+int rollback_unacked(
+    const struct Rollback *self, uint64_t *first, uint8_t *inputs, int max
+);
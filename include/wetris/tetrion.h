@@ -6,26 +6,40 @@
 
 #pragma once
 
-#include "input.h"
+/*
+ * The game rules. This part doesn't depend on SDL: it neither renders nor plays
+ * anything, instead it reports what happened through events, which are then
+ * handled by the frontend (see game.c).
+ */
+
+#include "board.h"
 #include "piece.h"
-#include "sfx_store.h"
-#include "tileset.h"
+#include "randomizer.h"
 #include "timer.h"
-#include "ui.h"
-
-#include <SDL3/SDL.h>
 
 #include <stdbool.h>
+#include <stdint.h>
 
+/*
+ * The rules advance in fixed ticks, independently of the frame rate. All
+ * durations below are converted to ticks according to the tick rate.
+ */
+#define DEFAULT_TICK_RATE 1000    /* ticks per second */
 #define FAST_FALL_INTERVAL 50     /* ms */
 #define DEFAULT_FALL_INTERVAL 350 /* ms */
 #define MIN_FALL_INTERVAL 50      /* ms */
 #define MAX_FALL_INTERVAL 320     /* ms */
 #define SCORE_SPEED_RATE 30       /* ms */
+#define DEFAULT_CLEAR_DELAY 200   /* ms */
 #define SPEED_UP_RATE 5
-#define TETRION_HEIGHT 21 /* the corner is also counted */
-#define TETRION_WIDTH 12  /* corners are counted too */
+#define TETRION_HEIGHT BOARD_HEIGHT
+#define TETRION_WIDTH BOARD_WIDTH
 #define MAX_SCORE_PER_LEVEL 100
+#define DEFAULT_PREVIEW 1
+#define TETRION_MAX_PREVIEW 6
+
+/* Bumped whenever a change of the rules alters recorded games. */
+#define TETRION_RULES_VERSION 1
 
 #define SCORE_ROW_DELETED 10
 #define SCORE_MOVE 1
@@ -34,37 +48,135 @@
 enum TetrionState {
     TETRION_STATE_NOT_STARTED,
     TETRION_STATE_NORMAL,
-    TETRION_STATE_UPDATING_ROWS,
+    TETRION_STATE_UPDATING_ROWS, /* full rows are shown before deletion */
     TETRION_STATE_GAME_OVER,
 };
 
+enum TetrionAction {
+    TETRION_ACTION_START,
+    TETRION_ACTION_MOVE_LEFT,
+    TETRION_ACTION_MOVE_RIGHT,
+    TETRION_ACTION_ROTATE,
+    TETRION_ACTION_ROTATE_CNT,
+    TETRION_ACTION_SOFT_DROP_ON,
+    TETRION_ACTION_SOFT_DROP_OFF,
+    TETRION_ACTION_HARD_DROP,
+
+    TOTAL_TETRION_ACTIONS
+};
+
+enum TetrionEvent {
+    TETRION_EVENT_STARTED,
+    TETRION_EVENT_RESTARTED,
+    TETRION_EVENT_MOVED,
+    TETRION_EVENT_ROTATED,
+    TETRION_EVENT_LANDED,
+    TETRION_EVENT_DROPPED,
+    TETRION_EVENT_ROW_DELETED,
+    TETRION_EVENT_LEVEL_UP,
+    TETRION_EVENT_SCORE_CHANGED,
+    TETRION_EVENT_NEXT_PIECE,
+    TETRION_EVENT_GAME_OVER,
+
+    TOTAL_TETRION_EVENTS
+};
+
+/* Points awarded by the rules, the defaults are the SCORE_* constants. */
+struct TetrionScoring {
+    int row_deleted; /* per row */
+    int landed;      /* per piece */
+    int move;        /* per row fallen */
+};
+
+struct TetrionConfig {
+    uint64_t seed;
+    enum RandomizerKind randomizer;
+    uint64_t clear_delay; /* ms, full rows are deleted right away when 0 */
+    uint32_t tick_rate;   /* ticks per second */
+    int preview;          /* pieces known ahead, 1..TETRION_MAX_PREVIEW */
+    struct TetrionScoring scoring;
+};
+
 struct Tetrion {
-    struct SDL_Rect rect;
-    enum TileId **tilemap;
-    struct SfxStore *sfx_store;
-    struct UiState *ui;
+    struct TetrionConfig config;
+    struct Board board;
+    /* Bumped whenever the locked blocks change, so views can cache them */
+    uint32_t generation;
 
     int score;
+    int lines; /* rows deleted in the current game */
     struct Piece piece;
-    struct Piece next_piece;
+    /* The upcoming pieces in order, only config.preview of them are used. */
+    struct Piece preview[TETRION_MAX_PREVIEW];
     uint64_t saved_fall_interval;
     bool lock_saved_fall_interval;
+    uint64_t time; /* ticks */
     struct Timer ticker;
+    struct Timer clear_timer;
     enum TetrionState state;
     bool dropped;
     int level;
+    uint64_t seed; /* the seed of the current game */
+    struct Randomizer randomizer;
+
+    /* Pending events, each kind is queued at most once until it's polled. */
+    enum TetrionEvent events[TOTAL_TETRION_EVENTS];
+    int event_count;
+    int event_head;
+    uint32_t pending_events;
 };
 
-bool tetrion_init(
-    struct Tetrion *self, struct SfxStore *sfx_store, struct UiState *ui, int x,
-    int y, int w, int h
+struct TetrionScoring tetrion_scoring_default(void);
+struct TetrionConfig tetrion_config_default(void);
+/*
+ * The whole state of the rules packed without any pointers, so it can be
+ * copied around freely. The configuration isn't included, a snapshot must be
+ * restored into a tetrion initialized with the same configuration.
+ */
+struct TetrionSnapshot {
+    uint64_t time;
+    struct Rng rng;
+    /* The board without the bottom wall, the rest is derived on restore */
+    uint16_t rows[BOARD_HEIGHT - 1];
+    uint32_t colors[BOARD_HEIGHT - 1];
+    int32_t score;
+    uint32_t lines;
+    uint32_t ticker_elapsed;
+    uint32_t clear_timer_elapsed;
+    uint32_t fall_interval;
+    uint32_t saved_fall_interval;
+    uint16_t level;
+    int8_t piece_x;
+    int8_t piece_y;
+    uint8_t piece_id;
+    uint8_t piece_rotation;
+    uint8_t preview[TETRION_MAX_PREVIEW];
+    uint8_t state;
+    uint8_t bag[TOTAL_PIECES];
+    uint8_t bag_left;
+    uint8_t flags;
+};
+
+void tetrion_init(struct Tetrion *self, const struct TetrionConfig *config);
+void tetrion_reset(struct Tetrion *self, uint64_t seed);
+void tetrion_tick(struct Tetrion *self);
+void tetrion_apply(struct Tetrion *self, enum TetrionAction action);
+bool tetrion_poll_event(struct Tetrion *self, enum TetrionEvent *event);
+/*
+ * Pushes the board up by the given number of garbage rows with a hole at the
+ * given column (0 is the leftmost one), e.g. sent by an opponent. The falling
+ * piece is pushed up along with the blocks below it. Blocks pushed over the top
+ * end the game.
+ */
+void tetrion_add_garbage(struct Tetrion *self, int rows, int hole);
+void tetrion_snapshot(
+    const struct Tetrion *self, struct TetrionSnapshot *snapshot
 );
-void tetrion_reset(struct Tetrion *self);
-void tetrion_deinit(struct Tetrion *self);
-void tetrion_update(struct Tetrion *self);
-void tetrion_handle_input(struct Tetrion *self, struct InputState *input);
-void tetrion_handle_pause(struct Tetrion *self);
-void tetrion_handle_resume(struct Tetrion *self);
-void tetrion_render(
-    struct Tetrion *self, SDL_Renderer *renderer, struct TileSet *tileset
+void tetrion_restore(
+    struct Tetrion *self, const struct TetrionSnapshot *snapshot
 );
+/*
+ * Checks what restoring relies on (piece kinds, walls...), for snapshots read
+ * from untrusted sources.
+ */
+bool tetrion_snapshot_valid(const struct TetrionSnapshot *snapshot);
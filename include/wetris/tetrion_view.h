@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#pragma once
+
+#include "tetrion.h"
+#include "tileset.h"
+
+#include <SDL3/SDL.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Draws a well. The locked blocks, walls and background change only when a
+ * piece lands or rows are deleted, so they're drawn into a texture once and
+ * that is copied every frame, only the falling piece and its shadow are drawn
+ * as tiles.
+ */
+struct TetrionView {
+    SDL_Texture *board;
+    /* What the texture shows */
+    uint32_t generation;
+    uint32_t flashed_rows;
+    bool valid;
+};
+
+bool tetrion_view_init(struct TetrionView *self, SDL_Renderer *renderer);
+void tetrion_view_deinit(struct TetrionView *self);
+/* Has the texture drawn again, e.g. after the renderer lost its contents. */
+void tetrion_view_invalidate(struct TetrionView *self);
+/*
+ * x and y are the screen coordinates of the top left corner of the well. The
+ * board is drawn right away, the piece and its shadow are queued into the
+ * batch.
+ */
+void tetrion_view_render(
+    struct TetrionView *self, const struct Tetrion *tetrion,
+    SDL_Renderer *renderer, struct TileSet *tileset, struct TileBatch *batch,
+    int x, int y
+);
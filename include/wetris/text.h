@@ -25,12 +25,23 @@ struct Text {
     enum TextAlignment align;
     char *data;
     size_t len;
+    size_t capacity; /* of data, including the terminator */
     struct Line *lines;
     size_t line_count;
     size_t line_capacity;
     struct SDL_Rect rect;
     struct SDL_Color fg;
     bool show;
+
+    /* The glyph quads, built on render when the text, position or color
+     * changed, and drawn with a single SDL_RenderGeometry() call */
+    SDL_Vertex *vertices;
+    int *indices;
+    int quad_count;
+    size_t quad_capacity;
+    int built_x, built_y;
+    struct SDL_Color built_fg;
+    bool stale;
 };
 
 void text_init(
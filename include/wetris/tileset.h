@@ -6,47 +6,47 @@
 
 #pragma once
 
+#include "piece.h"
+#include "tile.h"
+
 #include <SDL3/SDL.h>
 #include <stdbool.h>
 
 #define TILE_WIDTH 16
 #define TILE_HEIGHT 16
-
-enum TileId {
-    TILE_NULL,
-    TILE_WALL,
-    TILE_BACKGROUND,
-    TILE_FINAL_POS,
-    TILE_RED,
-    TILE_ORANGE,
-    TILE_YELLOW,
-    TILE_GREEN,
-    TILE_BLUE,
-    TILE_CYAN,
-    TILE_PURPLE,
-    TILE_WHITE,
-
-    TOTAL_TILES,
-};
-
-static inline bool tile_is_passable(enum TileId self) {
-    return self >= TILE_NULL && self <= TILE_FINAL_POS && self != TILE_WALL;
-}
-
-static inline bool tile_is_block(enum TileId self) {
-    return self >= TILE_RED && self <= TILE_WHITE;
-}
+/* Enough for two wells with their pieces and the whole preview. */
+#define TILE_BATCH_CAPACITY 1024
 
 struct TileSet {
-    SDL_FRect rects[TOTAL_TILES - 1];
+    SDL_FRect rects[TOTAL_TILES - 1]; /* in texture coordinates (0..1) */
     SDL_Texture *texture;
 };
 
+/*
+ * Tiles collected during a frame and drawn by a single SDL_RenderGeometry()
+ * call, as every draw call has its cost. Drawn earlier when it gets full.
+ */
+struct TileBatch {
+    SDL_Vertex vertices[TILE_BATCH_CAPACITY * 4];
+    int indices[TILE_BATCH_CAPACITY * 6]; /* the same for every frame */
+    int count;                            /* tiles */
+};
+
 bool tileset_load(
     struct TileSet *tileset, SDL_Renderer *renderer, const char *path
 );
 void tileset_deinit(struct TileSet *tileset);
-void tileset_render_tile(
-    struct TileSet *tileset, SDL_Renderer *renderer, enum TileId id, int x,
-    int y
+void tileset_batch_tile(
+    struct TileSet *tileset, struct TileBatch *batch, SDL_Renderer *renderer,
+    enum TileId id, int x, int y
 );
+void tileset_batch_piece(
+    struct TileSet *tileset, struct TileBatch *batch, SDL_Renderer *renderer,
+    const struct Piece *piece, int x, int y
+);
+/* Draws the collected tiles and empties the batch. */
+void tileset_render_batch(
+    struct TileSet *tileset, struct TileBatch *batch, SDL_Renderer *renderer
+);
+
+void tile_batch_init(struct TileBatch *self);
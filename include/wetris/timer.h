@@ -9,12 +9,16 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+/*
+ * The timer doesn't read any clock by itself, the current time is always
+ * supplied by the caller, in whatever unit it counts (e.g. ticks).
+ */
 struct Timer {
     uint64_t start_time;
     uint64_t interval;
 };
 
-struct Timer timer_new(uint64_t interval);
-void timer_restart(struct Timer *self);
-uint64_t timer_elapsed(const struct Timer *self);
-bool timer_done(const struct Timer *self);
+struct Timer timer_new(uint64_t interval, uint64_t now);
+void timer_restart(struct Timer *self, uint64_t now);
+uint64_t timer_elapsed(const struct Timer *self, uint64_t now);
+bool timer_done(const struct Timer *self, uint64_t now);
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#pragma once
+
+/*
+ * A fixed-size hash table of 64-bit values keyed by Zobrist hashes, shared by
+ * any number of threads without locks. Every entry stores its key XORed with
+ * its value, so an entry torn by two threads writing it at once simply doesn't
+ * match any key anymore. Newer entries always replace older ones.
+ */
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Threads beyond this share the counters, which stay exact, just slower */
+#define TRANS_TABLE_COUNTER_SLOTS 64
+
+struct TransEntry {
+    _Atomic uint64_t check; /* key ^ value */
+    _Atomic uint64_t value;
+};
+
+struct TransTableStats {
+    uint64_t probes;
+    uint64_t hits;
+    uint64_t stores;
+};
+
+/*
+ * Each thread counts in its own slot, on its own cache line, so the counters
+ * aren't a point of contention between threads probing the table.
+ */
+struct TransCounters {
+    _Alignas(64) _Atomic uint64_t probes;
+    _Atomic uint64_t hits;
+    _Atomic uint64_t stores;
+};
+
+struct TransTable {
+    struct TransEntry *entries;
+    size_t mask; /* the number of entries is a power of two */
+
+    struct TransCounters counters[TRANS_TABLE_COUNTER_SLOTS];
+};
+
+/* Allocates the largest table fitting into the given number of megabytes. */
+bool trans_table_init(struct TransTable *self, size_t megabytes);
+void trans_table_deinit(struct TransTable *self);
+/* Not safe while other threads use the table. */
+void trans_table_clear(struct TransTable *self);
+bool trans_table_probe(struct TransTable *self, uint64_t key, uint64_t *value);
+void trans_table_store(struct TransTable *self, uint64_t key, uint64_t value);
+/* Sums the counters of all threads. */
+void trans_table_stats(
+    const struct TransTable *self, struct TransTableStats *stats
+);
+/* Hits per probe, 0 before the first probe. */
+double trans_table_hit_rate(const struct TransTable *self);
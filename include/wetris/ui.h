@@ -12,7 +12,9 @@
  */
 
 #include "piece.h"
+#include "tetrion.h"
 #include "text.h"
+#include "tileset.h"
 
 #include <SDL3/SDL.h>
 
@@ -32,14 +34,22 @@ enum TextId {
 struct UiState {
     struct Text texts[TOTAL_TEXTS];
     struct Game *game;
-    struct Piece next_piece;
-    struct SDL_Point next_piece_pos;
+    struct Piece preview[TETRION_MAX_PREVIEW];
+    int preview_count;
+    struct SDL_Point preview_pos;
+    int score, level;
+    bool stats_dirty; /* laid out again by the next ui_render() */
+    bool dirty; /* changed since the last ui_render() */
 };
 
 void ui_init(struct UiState *self, struct Game *game);
 void ui_deinit(struct UiState *self);
+/* Only remembered, the stats are laid out once per ui_render(). */
 void ui_set_stats(struct UiState *self, int score, int level);
-void ui_set_next_piece(struct UiState *self, const struct Piece *piece);
+void ui_set_preview(
+    struct UiState *self, const struct Piece *pieces, int count
+);
 void ui_show_text(struct UiState *self, enum TextId id);
 void ui_hide_text(struct UiState *self, enum TextId id);
-void ui_render(struct UiState *self);
+/* The preview is queued into the batch, the texts are drawn right away. */
+void ui_render(struct UiState *self, struct TileBatch *batch);
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#pragma once
+
+/*
+ * A match of two players. Rows deleted by one player are sent to the other one
+ * as garbage. The match advances in frames, every frame applies the input of
+ * each player and ticks both tetrions once, so a match is reproduced exactly
+ * from the seed and the inputs like a replay.
+ */
+
+#include "rng.h"
+#include "tetrion.h"
+
+#include <stdint.h>
+
+#define VERSUS_PLAYERS 2
+#define VERSUS_FRAME_RATE 60 /* frames per second, the tick rate of the rules */
+
+/*
+ * The input of a player for one frame is a bit set of actions, the bit
+ * (1 << action) is set for every action pressed during the frame.
+ */
+#define VERSUS_INPUT(action) ((uint8_t)(1u << (action)))
+
+struct Versus {
+    struct Tetrion players[VERSUS_PLAYERS];
+    int lines[VERSUS_PLAYERS]; /* deleted rows already turned into garbage */
+    struct Rng rng;            /* places the holes of the garbage */
+    uint64_t frame;
+};
+
+struct VersusSnapshot {
+    struct TetrionSnapshot players[VERSUS_PLAYERS];
+    int32_t lines[VERSUS_PLAYERS];
+    struct Rng rng;
+    uint64_t frame;
+};
+
+/* Both players get the same pieces, the match starts right away. */
+void versus_init(struct Versus *self, uint64_t seed);
+void versus_step(struct Versus *self, const uint8_t inputs[VERSUS_PLAYERS]);
+void versus_snapshot(
+    const struct Versus *self, struct VersusSnapshot *snapshot
+);
+void versus_restore(
+    struct Versus *self, const struct VersusSnapshot *snapshot
+);
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#pragma once
+
+/*
+ * The public API of libwetris, for embedding the game rules in other programs
+ * (e.g. driving them from Python with ctypes). A game is an opaque handle and
+ * everything crossing the boundary is a plain integer or a byte buffer, so the
+ * ABI doesn't change with the internals. This header includes nothing but the
+ * standard library and may be copied alone.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(WETRIS_BUILD)
+#define WETRIS_API __declspec(dllexport)
+#elif defined(_WIN32)
+#define WETRIS_API __declspec(dllimport)
+#elif defined(__GNUC__)
+#define WETRIS_API __attribute__((visibility("default")))
+#else
+#define WETRIS_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bumped on every incompatible change of this header. */
+#define WETRIS_ABI_VERSION 1
+
+/* The playfield without the walls. */
+#define WETRIS_BOARD_WIDTH 10
+#define WETRIS_BOARD_HEIGHT 20
+#define WETRIS_BOARD_SIZE (WETRIS_BOARD_WIDTH * WETRIS_BOARD_HEIGHT)
+
+/*
+ * A board cell is 0 when empty, otherwise the kind of the piece that left the
+ * block plus one (Z, L, O, S, J, I, T). Cells of the falling piece have
+ * WETRIS_CELL_FALLING set as well.
+ */
+#define WETRIS_CELL_FALLING 0x80
+
+/* Large enough for a snapshot of any version of the library. */
+#define WETRIS_SNAPSHOT_SIZE 256
+
+enum WetrisAction {
+    WETRIS_ACTION_NONE = 0,
+    WETRIS_ACTION_MOVE_LEFT = 1,
+    WETRIS_ACTION_MOVE_RIGHT = 2,
+    WETRIS_ACTION_ROTATE = 3,
+    WETRIS_ACTION_ROTATE_CNT = 4,
+    WETRIS_ACTION_SOFT_DROP_ON = 5,
+    WETRIS_ACTION_SOFT_DROP_OFF = 6,
+    WETRIS_ACTION_HARD_DROP = 7,
+};
+
+struct Wetris;
+
+/* Returns WETRIS_ABI_VERSION of the library actually loaded. */
+WETRIS_API int wetris_abi_version(void);
+
+/*
+ * Creates a started game with the default rules, ticking 1000 times a second
+ * of game time. Returns NULL when out of memory.
+ */
+WETRIS_API struct Wetris *wetris_create(uint64_t seed);
+WETRIS_API void wetris_destroy(struct Wetris *self);
+/* Starts a new game, the board buffer stays where it is. */
+WETRIS_API void wetris_reset(struct Wetris *self, uint64_t seed);
+/*
+ * Applies the action (one of WetrisAction) and advances the game by one tick.
+ * Returns the score gained. Unknown actions are ignored and a game that is
+ * over stays over until it's reset.
+ */
+WETRIS_API int32_t wetris_step(struct Wetris *self, int action);
+
+/*
+ * The board as WETRIS_BOARD_SIZE cells, row by row from the top. The buffer
+ * belongs to the game and is updated in place by every call changing it, so it
+ * may be read at any time until the game is destroyed without copying it.
+ */
+WETRIS_API const uint8_t *wetris_board(const struct Wetris *self);
+/* Copies the board into a buffer of WETRIS_BOARD_SIZE bytes. */
+WETRIS_API void wetris_get_board(const struct Wetris *self, uint8_t *buffer);
+
+WETRIS_API int32_t wetris_score(const struct Wetris *self);
+WETRIS_API int wetris_level(const struct Wetris *self);
+WETRIS_API uint64_t wetris_time(const struct Wetris *self); /* ticks */
+WETRIS_API bool wetris_game_over(const struct Wetris *self);
+/* The kinds of the falling and of the next piece, in the order of the cells. */
+WETRIS_API int wetris_piece(const struct Wetris *self);
+WETRIS_API int wetris_next_piece(const struct Wetris *self);
+
+/*
+ * Saves the whole game into a buffer of at least WETRIS_SNAPSHOT_SIZE bytes.
+ * The snapshot holds no pointers, so it can be stored or sent anywhere and
+ * restored into any game of the same library version. Returns false when the
+ * buffer is too small.
+ */
+WETRIS_API bool wetris_snapshot(
+    const struct Wetris *self, void *buffer, size_t size
+);
+/*
+ * Returns false, leaving the game untouched, when the buffer doesn't hold a
+ * valid snapshot.
+ */
+WETRIS_API bool wetris_restore(
+    struct Wetris *self, const void *buffer, size_t size
+);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#pragma once
+
+/*
+ * Zobrist keys of board rows and pieces. A board hash is the XOR of the keys
+ * of its rows, so changing a row only swaps its old key for the new one.
+ * Instead of tables of random numbers, the keys are derived by scrambling the
+ * contents and the position with the splitmix64 finalizer, which is just as
+ * well distributed and needs no initialization.
+ */
+
+#include "piece.h"
+
+#include <stdint.h>
+
+static inline uint64_t zobrist_mix(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9u;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebu;
+
+    return z ^ (z >> 31);
+}
+
+/* The bits are the occupied inner cells of the row y, 0 for an empty row. */
+static inline uint64_t zobrist_row(uint32_t bits, int y) {
+    if (!bits) {
+        return 0;
+    }
+
+    return zobrist_mix((uint64_t)(uint32_t)y << 32 | bits);
+}
+
+static inline uint64_t zobrist_piece(const struct Piece *piece) {
+    uint64_t fields = (uint64_t)piece->id << 24 |
+                      (uint64_t)piece->rotation << 16 |
+                      (uint64_t)(uint8_t)piece->pos.x << 8 |
+                      (uint8_t)piece->pos.y;
+
+    /* Keeps the keys of pieces apart from the keys of rows */
+    return zobrist_mix(fields | 1ull << 63);
+}
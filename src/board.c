@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#include <wetris/board.h>
+#include <wetris/zobrist.h>
+
+#include <assert.h>
+
+static uint64_t row_hash(const struct Board *self, int y) {
+    return zobrist_row(self->rows[y] & BOARD_INNER_MASK, y);
+}
+
+struct Piece board_spawn_piece(enum PieceId id) {
+    struct Piece piece = piece_new(id);
+    piece.pos.x = BOARD_WIDTH / 2 - 1;
+
+    return piece;
+}
+
+void board_clear(struct Board *self) {
+    for (int y = 0; y < BOARD_HEIGHT - 1; ++y) {
+        self->rows[y] = BOARD_EMPTY_ROW;
+        self->colors[y] = 0;
+    }
+
+    /* Bottom */
+    self->rows[BOARD_HEIGHT - 1] = BOARD_FULL_ROW;
+
+    for (int x = 1; x < BOARD_WIDTH - 1; ++x) {
+        self->heights[x] = 0;
+    }
+
+    /* Walls */
+    self->heights[0] = BOARD_HEIGHT - 1;
+    self->heights[BOARD_WIDTH - 1] = BOARD_HEIGHT - 1;
+
+    /* Empty rows have no key */
+    self->hash = 0;
+}
+
+void board_put(
+    struct Board *self, uint16_t mask, int x, int y, enum TileId tile
+) {
+    assert(tile_is_block(tile));
+
+    uint32_t color = (uint32_t)(tile - TILE_RED + 1);
+    uint64_t old_hash = 0;
+
+    /* The keys of the touched rows are swapped for the new ones below */
+    for (int row_y = y; row_y < y + PIECE_HEIGHT; ++row_y) {
+        if (row_y >= 0 && row_y < BOARD_HEIGHT - 1) {
+            old_hash ^= row_hash(self, row_y);
+        }
+    }
+
+    for (int i = 0; i < PIECE_WIDTH * PIECE_HEIGHT; ++i) {
+        if (!(mask & (1u << i))) {
+            continue;
+        }
+
+        int tile_x = x + i % PIECE_WIDTH;
+        int tile_y = y + i / PIECE_WIDTH;
+
+        /* Walls are never overwritten, the piece is expected to fit. */
+        if (tile_x <= 0 || tile_x >= BOARD_WIDTH - 1 || tile_y < 0 ||
+            tile_y >= BOARD_HEIGHT - 1) {
+            continue;
+        }
+
+        int shift = BOARD_COLOR_BITS * (tile_x - 1);
+
+        self->rows[tile_y] |= (uint16_t)(1u << tile_x);
+        self->colors[tile_y] &= ~(BOARD_COLOR_MASK << shift);
+        self->colors[tile_y] |= color << shift;
+
+        if (tile_y < board_top(self, tile_x)) {
+            self->heights[tile_x] = (uint8_t)(BOARD_HEIGHT - 1 - tile_y);
+        }
+    }
+
+    self->hash ^= old_hash;
+
+    for (int row_y = y; row_y < y + PIECE_HEIGHT; ++row_y) {
+        if (row_y >= 0 && row_y < BOARD_HEIGHT - 1) {
+            self->hash ^= row_hash(self, row_y);
+        }
+    }
+}
+
+int board_clear_rows(struct Board *self) {
+    int dst = BOARD_HEIGHT - 2; /* -2 for the bottom wall */
+
+    for (int y = BOARD_HEIGHT - 2; y >= 0; --y) {
+        if (board_row_full(self, y)) {
+            continue;
+        }
+
+        self->rows[dst] = self->rows[y];
+        self->colors[dst] = self->colors[y];
+        --dst;
+    }
+
+    int cleared = dst + 1;
+
+    for (; dst >= 0; --dst) {
+        self->rows[dst] = BOARD_EMPTY_ROW;
+        self->colors[dst] = 0;
+    }
+
+    if (cleared > 0) {
+        /* Every row that moved has a new key */
+        board_update_heights(self);
+        board_update_hash(self);
+    }
+
+    return cleared;
+}
+
+int board_add_garbage(struct Board *self, int rows, int hole) {
+    assert(rows >= 0 && rows < BOARD_HEIGHT);
+    assert(hole >= 0 && hole < BOARD_WIDTH - 2);
+
+    int bottom = BOARD_HEIGHT - 1;
+    int lost = 0;
+
+    for (int y = 0; y < rows; ++y) {
+        if (self->rows[y] != BOARD_EMPTY_ROW) {
+            ++lost;
+        }
+    }
+
+    for (int y = 0; y < bottom - rows; ++y) {
+        self->rows[y] = self->rows[y + rows];
+        self->colors[y] = self->colors[y + rows];
+    }
+
+    for (int y = bottom - rows; y < bottom; ++y) {
+        self->rows[y] = (uint16_t)(BOARD_FULL_ROW & ~(1u << (hole + 1)));
+        self->colors[y] = 0;
+    }
+
+    if (rows > 0) {
+        board_update_heights(self);
+        board_update_hash(self);
+    }
+
+    return lost;
+}
+
+uint32_t board_full_rows(const struct Board *self) {
+    uint32_t full_rows = 0;
+
+    for (int y = 0; y < BOARD_HEIGHT - 1; ++y) {
+        if (board_row_full(self, y)) {
+            full_rows |= 1u << y;
+        }
+    }
+
+    return full_rows;
+}
+
+void board_update_heights(struct Board *self) {
+    /* Inner columns whose surface hasn't been found yet */
+    uint32_t pending = BOARD_EMPTY_ROW ^ BOARD_FULL_ROW;
+
+    for (int y = 0; y < BOARD_HEIGHT - 1 && pending; ++y) {
+        uint32_t found = self->rows[y] & pending;
+
+        for (int x = 1; found && x < BOARD_WIDTH - 1; ++x) {
+            if ((found >> x) & 1u) {
+                self->heights[x] = (uint8_t)(BOARD_HEIGHT - 1 - y);
+            }
+        }
+
+        pending &= ~(uint32_t)self->rows[y];
+    }
+
+    for (int x = 1; x < BOARD_WIDTH - 1; ++x) {
+        if ((pending >> x) & 1u) {
+            self->heights[x] = 0;
+        }
+    }
+}
+
+void board_update_hash(struct Board *self) {
+    self->hash = 0;
+
+    for (int y = 0; y < BOARD_HEIGHT - 1; ++y) {
+        self->hash ^= row_hash(self, y);
+    }
+}
+
+int board_next_occupied(const struct Board *self, int x, int y) {
+    int top = board_top(self, x);
+
+    if (y < top) {
+        return top;
+    }
+
+    /* Below an overhang */
+    do {
+        ++y;
+    } while (y < BOARD_HEIGHT - 1 && !board_occupied(self, x, y));
+
+    return y;
+}
+
+int board_drop_distance(const struct Board *self, const struct Piece *piece) {
+    uint16_t mask = piece_mask(piece);
+    int distance = BOARD_HEIGHT;
+
+    for (int x = 0; x < PIECE_WIDTH; ++x) {
+        /* The lowest block of the column */
+        for (int y = PIECE_HEIGHT - 1; y >= 0; --y) {
+            if (!((mask >> (y * PIECE_WIDTH + x)) & 1u)) {
+                continue;
+            }
+
+            int tile_x = piece->pos.x + x;
+            int tile_y = piece->pos.y + y;
+            int gap = board_next_occupied(self, tile_x, tile_y) - tile_y - 1;
+
+            if (gap < distance) {
+                distance = gap;
+            }
+
+            break;
+        }
+    }
+
+    return distance;
+}
+
+enum TileId board_tile(const struct Board *self, int x, int y) {
+    if (!board_occupied(self, x, y)) {
+        return TILE_BACKGROUND;
+    }
+
+    if (x == 0 || x == BOARD_WIDTH - 1 || y == BOARD_HEIGHT - 1) {
+        return TILE_WALL;
+    }
+
+    uint32_t color =
+        (self->colors[y] >> (BOARD_COLOR_BITS * (x - 1))) & BOARD_COLOR_MASK;
+
+    /* Garbage rows have no colors */
+    if (color == 0) {
+        return TILE_WHITE;
+    }
+
+    return (enum TileId)(TILE_RED + (int)color - 1);
+}
+
+bool board_rotate_piece(
+    const struct Board *self, struct Piece *piece, int rotation
+) {
+    uint16_t mask = g_piece_masks[piece->id][rotation];
+    const struct KickOff *kick_offs =
+        piece_kick_offs(piece->id, piece->rotation, rotation);
+
+    for (int i = 0; i < PIECE_KICK_TESTS; ++i) {
+        int x = piece->pos.x + kick_offs[i].x;
+        int y = piece->pos.y + kick_offs[i].y;
+
+        if (board_fits(self, mask, x, y)) {
+            piece->rotation = rotation;
+            piece->pos.x = x;
+            piece->pos.y = y;
+
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,494 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#include <wetris/bot.h>
+#include <wetris/planner.h>
+#include <wetris/zobrist.h>
+
+#include <assert.h>
+#include <float.h>
+#include <stdint.h>
+#include <string.h>
+
+#define NO_PARENT (-1)
+
+/* How far a kick can move a piece vertically */
+#define KICK_REACH 2
+
+#define TOTAL_SEARCH_INPUTS 5
+
+static const enum TetrionAction g_search_inputs[TOTAL_SEARCH_INPUTS] = {
+    TETRION_ACTION_MOVE_LEFT,  TETRION_ACTION_MOVE_RIGHT,
+    TETRION_ACTION_ROTATE,     TETRION_ACTION_ROTATE_CNT,
+    TETRION_ACTION_SOFT_DROP_ON,
+};
+
+static int state_index(const struct Piece *piece) {
+    int x = piece->pos.x - BOT_SEARCH_MIN_X;
+    int y = piece->pos.y - BOT_SEARCH_MIN_Y;
+
+    assert(x >= 0 && x < BOT_SEARCH_WIDTH && y >= 0 && y < BOT_SEARCH_HEIGHT);
+
+    return (y * BOT_SEARCH_WIDTH + x) * PIECE_ROTATIONS + piece->rotation;
+}
+
+static struct Piece state_piece(enum PieceId id, int index) {
+    struct Piece piece = piece_new(id);
+
+    piece.rotation = index % PIECE_ROTATIONS;
+    index /= PIECE_ROTATIONS;
+    piece.pos.x = index % BOT_SEARCH_WIDTH + BOT_SEARCH_MIN_X;
+    piece.pos.y = index / BOT_SEARCH_WIDTH + BOT_SEARCH_MIN_Y;
+
+    return piece;
+}
+
+/*
+ * Identifies the cells covered by a piece, so rotations of a symmetric piece
+ * landing on the same cells are considered once.
+ */
+static uint32_t landing_key(const struct Piece *piece) {
+    uint32_t mask = piece_mask(piece);
+    int x = piece->pos.x;
+    int y = piece->pos.y;
+
+    while (!(mask & 0xfu)) {
+        mask >>= PIECE_WIDTH;
+        ++y;
+    }
+
+    /* The blocks never cross into the previous row, the column is empty */
+    while (!(mask & 0x1111u)) {
+        mask >>= 1;
+        ++x;
+    }
+
+    return mask | (uint32_t)(x + 8) << 16 | (uint32_t)(y + 8) << 24;
+}
+
+static bool apply_input(
+    const struct Board *board, struct Piece *piece, enum TetrionAction input
+) {
+    struct Piece moved = *piece;
+
+    switch (input) {
+    case TETRION_ACTION_MOVE_LEFT:
+        --moved.pos.x;
+
+        break;
+    case TETRION_ACTION_MOVE_RIGHT:
+        ++moved.pos.x;
+
+        break;
+    case TETRION_ACTION_ROTATE:
+        return board_rotate_piece(
+            board, piece, piece_rotation_cw(piece->rotation)
+        );
+    case TETRION_ACTION_ROTATE_CNT:
+        return board_rotate_piece(
+            board, piece, piece_rotation_cnt(piece->rotation)
+        );
+    case TETRION_ACTION_SOFT_DROP_ON:
+        ++moved.pos.y;
+
+        break;
+    default:
+        return false;
+    }
+
+    if (!board_piece_fits(board, &moved)) {
+        return false;
+    }
+
+    *piece = moved;
+
+    return true;
+}
+
+static void add_landing(
+    struct BotLandings *self, const struct Piece *piece, int state
+) {
+    uint32_t key = landing_key(piece);
+
+    for (int i = 0; i < self->count; ++i) {
+        if (self->landings[i].key == key) {
+            return;
+        }
+    }
+
+    if (self->count == BOT_MAX_LANDINGS) {
+        return;
+    }
+
+    struct BotLanding *landing = &self->landings[self->count++];
+
+    landing->piece = *piece;
+    landing->state = state;
+    landing->key = key;
+}
+
+/*
+ * Returns the lowest position from which a piece and all of its kicks stay in
+ * the empty rows above the stack. Above it, moving down changes nothing but
+ * the position, so the piece can skip straight there.
+ */
+static int free_fall_limit(const struct Board *board) {
+    int surface = 0;
+
+    while (surface < BOARD_HEIGHT - 1 &&
+           board->rows[surface] == BOARD_EMPTY_ROW) {
+        ++surface;
+    }
+
+    return surface - PIECE_HEIGHT - KICK_REACH;
+}
+
+/* Visits the states one move (or one row down when falling) away. */
+static void expand(
+    struct BotLandings *self, const struct Board *board, enum PieceId id,
+    int index, bool moving, bool falling, int free_limit
+) {
+    struct Piece current = state_piece(id, index);
+
+    if (!falling) {
+        struct Piece landed = current;
+
+        landed.pos.y += board_drop_distance(board, &current);
+        add_landing(self, &landed, index);
+    }
+
+    for (int i = 0; i < TOTAL_SEARCH_INPUTS; ++i) {
+        enum TetrionAction input = g_search_inputs[i];
+        struct Piece next = current;
+        int repeat = 1;
+
+        if (input == TETRION_ACTION_SOFT_DROP_ON) {
+            if (!falling) {
+                continue;
+            }
+
+            if (current.pos.y < free_limit) {
+                repeat = free_limit - current.pos.y;
+                next.pos.y = free_limit;
+            } else if (!apply_input(board, &next, input)) {
+                /* A piece that cannot move down has landed */
+                add_landing(self, &current, index);
+
+                continue;
+            }
+        } else if (!moving || !apply_input(board, &next, input)) {
+            continue;
+        }
+
+        int next_index = state_index(&next);
+
+        if (self->visited[next_index]) {
+            continue;
+        }
+
+        self->visited[next_index] = 1;
+        self->parent[next_index] = (int16_t)index;
+        self->input[next_index] = (uint8_t)input;
+        self->repeat[next_index] = (uint8_t)repeat;
+        self->queue[self->queue_size++] = (uint16_t)next_index;
+    }
+}
+
+/*
+ * The landings reachable without moving down are found first, so they're hard
+ * dropped right away, the rest (tucks and spins) are found by letting the
+ * piece fall afterwards.
+ */
+void bot_landings_find(
+    struct BotLandings *self, const struct Board *board,
+    const struct Piece *piece
+) {
+    memset(self->visited, 0, sizeof(self->visited));
+    self->queue_size = 0;
+    self->count = 0;
+
+    if (!board_piece_fits(board, piece)) {
+        return;
+    }
+
+    int free_limit = free_fall_limit(board);
+    int start = state_index(piece);
+
+    self->visited[start] = 1;
+    self->parent[start] = NO_PARENT;
+    self->queue[self->queue_size++] = (uint16_t)start;
+
+    for (int head = 0; head < self->queue_size; ++head) {
+        expand(self, board, piece->id, self->queue[head], true, false, 0);
+    }
+
+    /* The states above were already moved in every direction */
+    int moved = self->queue_size;
+
+    for (int head = 0; head < self->queue_size; ++head) {
+        expand(
+            self, board, piece->id, self->queue[head], head >= moved, true,
+            free_limit
+        );
+    }
+}
+
+bool bot_landings_inputs(
+    const struct BotLandings *self, int landing, struct BotPlacement *placement
+) {
+    int i = self->landings[landing].state;
+
+    /* The hard drop takes care of the final fall */
+    while (self->parent[i] != NO_PARENT &&
+           self->input[i] == TETRION_ACTION_SOFT_DROP_ON) {
+        i = self->parent[i];
+    }
+
+    int last = i;
+    int count = 1;
+
+    for (; self->parent[i] != NO_PARENT; i = self->parent[i]) {
+        count += self->repeat[i];
+    }
+
+    if (count > BOT_MAX_INPUTS) {
+        return false;
+    }
+
+    placement->input_count = count;
+    placement->inputs[--count] = TETRION_ACTION_HARD_DROP;
+
+    for (i = last; self->parent[i] != NO_PARENT; i = self->parent[i]) {
+        for (int j = 0; j < self->repeat[i]; ++j) {
+            placement->inputs[--count] = (enum TetrionAction)self->input[i];
+        }
+    }
+
+    placement->piece = self->landings[landing].piece;
+
+    return true;
+}
+
+int bot_place(struct Board *board, const struct Piece *piece) {
+    board_put(
+        board, piece_mask(piece), piece->pos.x, piece->pos.y,
+        piece_tile(piece->id)
+    );
+
+    return board_clear_rows(board);
+}
+
+/*
+ * Scores the best landing of the next piece on the board, leaving out the rows
+ * cleared by the current piece. That way the score depends on the board and
+ * the piece only.
+ */
+static double best_landing(
+    struct BotLandings *scratch, const struct Board *board,
+    const struct Piece *next, const struct BotWeights *weights
+) {
+    struct Board children[BOT_MAX_LANDINGS];
+    struct BoardFeatures features[BOT_MAX_LANDINGS];
+    int cleared[BOT_MAX_LANDINGS];
+    double best = -DBL_MAX;
+
+    bot_landings_find(scratch, board, next);
+
+    for (int i = 0; i < scratch->count; ++i) {
+        children[i] = *board;
+        cleared[i] = bot_place(&children[i], &scratch->landings[i].piece);
+    }
+
+    features_compute_batch(children, scratch->count, features);
+
+    for (int i = 0; i < scratch->count; ++i) {
+        double score = bot_evaluate(&features[i], cleared[i], weights);
+
+        if (score > best) {
+            best = score;
+        }
+    }
+
+    return best;
+}
+
+/* Different weights score the same board differently, so they're hashed too */
+uint64_t bot_weights_key(const struct BotWeights *weights) {
+    const double values[] = {
+        weights->holes,           weights->height,
+        weights->bumpiness,       weights->lines,
+        weights->row_transitions, weights->column_transitions,
+        weights->wells,
+    };
+    uint64_t key = 0;
+
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+        uint64_t bits;
+
+        memcpy(&bits, &values[i], sizeof(bits));
+        key = zobrist_mix(key ^ bits);
+    }
+
+    return key;
+}
+
+double bot_look_ahead(
+    struct BotLandings *scratch, const struct Board *board,
+    const struct Piece *next, const struct BotWeights *weights,
+    struct TransTable *table, uint64_t salt
+) {
+    uint64_t key = board->hash ^ zobrist_piece(next) ^ salt;
+    uint64_t bits;
+    double best;
+
+    if (table && trans_table_probe(table, key, &bits)) {
+        memcpy(&best, &bits, sizeof(best));
+    } else {
+        best = best_landing(scratch, board, next, weights);
+
+        if (table) {
+            memcpy(&bits, &best, sizeof(bits));
+            trans_table_store(table, key, bits);
+        }
+    }
+
+    return best;
+}
+
+struct BotWeights bot_weights_default(void) {
+    struct BotWeights weights = {
+        .holes = -0.35663,
+        .height = -0.510066,
+        .bumpiness = -0.184483,
+        .lines = 0.760666,
+        .row_transitions = 0,
+        .column_transitions = 0,
+        .wells = 0,
+    };
+
+    return weights;
+}
+
+double bot_evaluate(
+    const struct BoardFeatures *features, int lines,
+    const struct BotWeights *weights
+) {
+    return weights->holes * features->holes +
+           weights->height * features->aggregate_height +
+           weights->bumpiness * features->bumpiness + weights->lines * lines +
+           weights->row_transitions * features->row_transitions +
+           weights->column_transitions * features->column_transitions +
+           weights->wells * features->wells;
+}
+
+bool bot_search(
+    const struct Tetrion *tetrion, const struct BotWeights *weights,
+    struct TransTable *table, struct BotPlacement *best
+) {
+    if (tetrion->state != TETRION_STATE_NORMAL) {
+        return false;
+    }
+
+    struct BotLandings scratch[2];
+    uint64_t salt = table ? bot_weights_key(weights) : 0;
+    bool found = false;
+
+    bot_landings_find(&scratch[0], &tetrion->board, &tetrion->piece);
+
+    for (int i = 0; i < scratch[0].count; ++i) {
+        const struct BotLanding *landing = &scratch[0].landings[i];
+        struct Board board = tetrion->board;
+        int lines = bot_place(&board, &landing->piece);
+        double score = bot_look_ahead(
+            &scratch[1], &board, &tetrion->preview[0], weights, table, salt
+        );
+
+        /* The score is linear in the cleared rows */
+        score += weights->lines * lines;
+
+        if (found && score <= best->score) {
+            continue;
+        }
+
+        if (!bot_landings_inputs(&scratch[0], i, best)) {
+            continue;
+        }
+
+        best->lines = lines;
+        best->score = score;
+        found = true;
+    }
+
+    return found;
+}
+
+void bot_player_init(struct BotPlayer *self, const struct BotWeights *weights) {
+    self->weights = *weights;
+    self->table = NULL;
+    self->planner = NULL;
+    self->next_input = -1;
+    self->falling = false;
+    self->fall_y = 0;
+}
+
+static bool same_piece(const struct Piece *a, const struct Piece *b) {
+    return a->id == b->id && a->rotation == b->rotation &&
+           a->pos.x == b->pos.x && a->pos.y == b->pos.y;
+}
+
+static void follow_plan(struct BotPlayer *self, struct Tetrion *tetrion) {
+    if (self->falling) {
+        if (tetrion->piece.pos.y == self->fall_y) {
+            return;
+        }
+
+        tetrion_apply(tetrion, TETRION_ACTION_SOFT_DROP_OFF);
+        self->falling = false;
+    }
+
+    if (self->next_input == self->plan.input_count) {
+        /* The dropped piece hasn't been locked yet */
+        if (same_piece(&tetrion->piece, &self->plan.piece)) {
+            return;
+        }
+
+        self->next_input = -1;
+    }
+
+    if (self->next_input < 0) {
+        bool found =
+            self->planner
+                ? planner_search(self->planner, tetrion, &self->plan)
+                : bot_search(tetrion, &self->weights, self->table, &self->plan);
+
+        if (!found) {
+            return;
+        }
+
+        self->next_input = 0;
+    }
+
+    while (self->next_input < self->plan.input_count) {
+        enum TetrionAction input = self->plan.inputs[self->next_input++];
+
+        tetrion_apply(tetrion, input);
+
+        if (input == TETRION_ACTION_SOFT_DROP_ON) {
+            self->falling = true;
+            self->fall_y = tetrion->piece.pos.y;
+
+            return;
+        }
+    }
+}
+
+void bot_player_tick(struct BotPlayer *self, struct Tetrion *tetrion) {
+    if (tetrion->state == TETRION_STATE_NORMAL) {
+        follow_plan(self, tetrion);
+    }
+
+    tetrion_tick(tetrion);
+}
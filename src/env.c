@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#include <wetris/env.h>
+#include <wetris/rng.h>
+
+#include <stdlib.h>
+
+static struct Piece spawn_piece(struct Randomizer *randomizer) {
+    return board_spawn_piece(randomizer_next(randomizer));
+}
+
+static void reset_game(struct EnvBatch *self, int i, uint64_t seed) {
+    struct Randomizer *randomizer = &self->randomizers[i];
+
+    randomizer_init(randomizer, self->randomizer, seed);
+    board_clear(&self->boards[i]);
+    self->pieces[i] = spawn_piece(randomizer);
+    self->next_pieces[i] = spawn_piece(randomizer);
+    self->scores[i] = 0;
+    self->steps[i] = 0;
+}
+
+static bool try_move(
+    const struct Board *board, struct Piece *piece, int dx, int dy
+) {
+    struct Piece moved = *piece;
+    moved.pos.x += dx;
+    moved.pos.y += dy;
+
+    if (!board_piece_fits(board, &moved)) {
+        return false;
+    }
+
+    *piece = moved;
+
+    return true;
+}
+
+/* Returns the score gained by the action. */
+static int apply(const struct EnvBatch *self, int i, enum EnvAction action) {
+    const struct Board *board = &self->boards[i];
+    struct Piece *piece = &self->pieces[i];
+    int distance;
+
+    switch (action) {
+    case ENV_ACTION_NONE:
+        break;
+    case ENV_ACTION_MOVE_LEFT:
+        try_move(board, piece, -1, 0);
+
+        break;
+    case ENV_ACTION_MOVE_RIGHT:
+        try_move(board, piece, 1, 0);
+
+        break;
+    case ENV_ACTION_ROTATE:
+        board_rotate_piece(board, piece, piece_rotation_cw(piece->rotation));
+
+        break;
+    case ENV_ACTION_ROTATE_CNT:
+        board_rotate_piece(board, piece, piece_rotation_cnt(piece->rotation));
+
+        break;
+    case ENV_ACTION_SOFT_DROP:
+        return try_move(board, piece, 0, 1) ? self->scoring.move : 0;
+    case ENV_ACTION_HARD_DROP:
+        distance = board_drop_distance(board, piece);
+        piece->pos.y += distance;
+
+        return self->scoring.move * distance;
+    case TOTAL_ENV_ACTIONS:
+        break;
+    }
+
+    return 0;
+}
+
+/* Returns the score gained, over is set when the next piece doesn't fit. */
+static int fall(struct EnvBatch *self, int i, bool *over) {
+    struct Board *board = &self->boards[i];
+    struct Piece *piece = &self->pieces[i];
+
+    *over = false;
+
+    if (try_move(board, piece, 0, 1)) {
+        return self->scoring.move;
+    }
+
+    board_put(
+        board, piece_mask(piece), piece->pos.x, piece->pos.y,
+        piece_tile(piece->id)
+    );
+
+    int score = self->scoring.landed +
+                self->scoring.row_deleted * board_clear_rows(board);
+
+    *piece = self->next_pieces[i];
+    self->next_pieces[i] = spawn_piece(&self->randomizers[i]);
+
+    *over = !board_piece_fits(board, piece);
+
+    return score;
+}
+
+bool env_batch_init(
+    struct EnvBatch *self, int size, const struct TetrionConfig *config
+) {
+    size_t count = (size_t)size;
+
+    self->size = size;
+    self->randomizer = config->randomizer;
+    self->scoring = config->scoring;
+    self->boards = malloc(count * sizeof(*self->boards));
+    self->pieces = malloc(count * sizeof(*self->pieces));
+    self->next_pieces = malloc(count * sizeof(*self->next_pieces));
+    self->scores = malloc(count * sizeof(*self->scores));
+    self->steps = malloc(count * sizeof(*self->steps));
+    self->randomizers = malloc(count * sizeof(*self->randomizers));
+
+    if (!self->boards || !self->pieces || !self->next_pieces ||
+        !self->scores || !self->steps || !self->randomizers) {
+        env_batch_deinit(self);
+
+        return false;
+    }
+
+    /* Every game gets its own seed, derived from the batch one */
+    struct Rng rng;
+    rng_seed(&rng, config->seed);
+
+    for (int i = 0; i < size; ++i) {
+        reset_game(self, i, rng_next64(&rng));
+    }
+
+    return true;
+}
+
+void env_batch_deinit(struct EnvBatch *self) {
+    free(self->boards);
+    free(self->pieces);
+    free(self->next_pieces);
+    free(self->scores);
+    free(self->steps);
+    free(self->randomizers);
+
+    self->boards = NULL;
+    self->pieces = NULL;
+    self->next_pieces = NULL;
+    self->scores = NULL;
+    self->steps = NULL;
+    self->randomizers = NULL;
+    self->size = 0;
+}
+
+void env_batch_step(
+    struct EnvBatch *self, const uint8_t *actions, int32_t *rewards,
+    bool *done
+) {
+    for (int i = 0; i < self->size; ++i) {
+        enum EnvAction action = actions[i] < TOTAL_ENV_ACTIONS
+                                    ? (enum EnvAction)actions[i]
+                                    : ENV_ACTION_NONE;
+        int reward = apply(self, i, action);
+
+        reward += fall(self, i, &done[i]);
+        rewards[i] = reward;
+
+        if (done[i]) {
+            /* Like restarting a tetrion, the next game is seeded from the
+             * current one */
+            reset_game(self, i, rng_next64(&self->randomizers[i].rng));
+        } else {
+            self->scores[i] += reward;
+            ++self->steps[i];
+        }
+    }
+}
@@ -0,0 +1,306 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#include <wetris/features.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+/* WETRIS_SCALAR_FEATURES forces the portable kernel, e.g. to test it */
+#if defined(WETRIS_SCALAR_FEATURES)
+#elif defined(__AVX2__)
+#define FEATURES_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) ||                                  \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FEATURES_SSE2
+#include <emmintrin.h>
+#endif
+
+/* Bit x covers the cells x and x + 1 */
+#define PAIRS_MASK ((uint16_t)((1u << (BOARD_WIDTH - 1)) - 1))
+#define PLAYFIELD_CELLS (FEATURES_COLUMNS * (BOARD_HEIGHT - 1))
+
+/*
+ * The rows are padded with full rows, which add nothing to any of the sums
+ * (just like the floor), so the kernels never need a partial vector.
+ */
+#define PADDED_ROWS 32
+
+static int popcount(uint32_t bits) {
+    bits = bits - ((bits >> 1) & 0x55555555u);
+    bits = (bits & 0x33333333u) + ((bits >> 2) & 0x33333333u);
+    bits = (bits + (bits >> 4)) & 0x0f0f0f0fu;
+
+    return (int)((bits * 0x01010101u) >> 24);
+}
+
+struct RowSums {
+    int empty_cells;
+    int row_transitions;
+    int column_transitions;
+};
+
+#if defined(FEATURES_AVX2)
+static __m256i popcount16(__m256i x) {
+    __m256i m1 = _mm256_set1_epi16(0x5555);
+    __m256i m2 = _mm256_set1_epi16(0x3333);
+    __m256i m4 = _mm256_set1_epi16(0x0f0f);
+
+    x = _mm256_sub_epi16(x, _mm256_and_si256(_mm256_srli_epi16(x, 1), m1));
+    x = _mm256_add_epi16(
+        _mm256_and_si256(x, m2), _mm256_and_si256(_mm256_srli_epi16(x, 2), m2)
+    );
+    x = _mm256_and_si256(_mm256_add_epi16(x, _mm256_srli_epi16(x, 4)), m4);
+
+    return _mm256_and_si256(
+        _mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), _mm256_set1_epi16(0x1f)
+    );
+}
+
+static int sum16(__m256i x) {
+    __m256i sums = _mm256_madd_epi16(x, _mm256_set1_epi16(1));
+    __m128i half = _mm_add_epi32(
+        _mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1)
+    );
+
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4e));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xb1));
+
+    return _mm_cvtsi128_si32(half);
+}
+
+static void sum_rows(
+    const uint16_t *rows, uint16_t *well_rows, struct RowSums *sums
+) {
+    __m256i inner = _mm256_set1_epi16((short)BOARD_INNER_MASK);
+    __m256i pairs = _mm256_set1_epi16((short)PAIRS_MASK);
+    __m256i empty = _mm256_setzero_si256();
+    __m256i row_trans = _mm256_setzero_si256();
+    __m256i column_trans = _mm256_setzero_si256();
+
+    for (int y = 0; y < PADDED_ROWS; y += 16) {
+        __m256i row = _mm256_loadu_si256((const __m256i *)&rows[y]);
+        __m256i below = _mm256_loadu_si256((const __m256i *)&rows[y + 1]);
+        __m256i left = _mm256_slli_epi16(row, 1);
+        __m256i right = _mm256_srli_epi16(row, 1);
+
+        empty = _mm256_add_epi16(
+            empty, popcount16(_mm256_andnot_si256(row, inner))
+        );
+        row_trans = _mm256_add_epi16(
+            row_trans,
+            popcount16(_mm256_and_si256(_mm256_xor_si256(row, right), pairs))
+        );
+        column_trans = _mm256_add_epi16(
+            column_trans,
+            popcount16(_mm256_and_si256(_mm256_xor_si256(row, below), inner))
+        );
+        _mm256_storeu_si256(
+            (__m256i *)&well_rows[y],
+            _mm256_andnot_si256(
+                row, _mm256_and_si256(_mm256_and_si256(left, right), inner)
+            )
+        );
+    }
+
+    sums->empty_cells = sum16(empty);
+    sums->row_transitions = sum16(row_trans);
+    sums->column_transitions = sum16(column_trans);
+}
+#elif defined(FEATURES_SSE2)
+static __m128i popcount16(__m128i x) {
+    __m128i m1 = _mm_set1_epi16(0x5555);
+    __m128i m2 = _mm_set1_epi16(0x3333);
+    __m128i m4 = _mm_set1_epi16(0x0f0f);
+
+    x = _mm_sub_epi16(x, _mm_and_si128(_mm_srli_epi16(x, 1), m1));
+    x = _mm_add_epi16(
+        _mm_and_si128(x, m2), _mm_and_si128(_mm_srli_epi16(x, 2), m2)
+    );
+    x = _mm_and_si128(_mm_add_epi16(x, _mm_srli_epi16(x, 4)), m4);
+
+    return _mm_and_si128(
+        _mm_add_epi16(x, _mm_srli_epi16(x, 8)), _mm_set1_epi16(0x1f)
+    );
+}
+
+static int sum16(__m128i x) {
+    __m128i sums = _mm_madd_epi16(x, _mm_set1_epi16(1));
+
+    sums = _mm_add_epi32(sums, _mm_shuffle_epi32(sums, 0x4e));
+    sums = _mm_add_epi32(sums, _mm_shuffle_epi32(sums, 0xb1));
+
+    return _mm_cvtsi128_si32(sums);
+}
+
+static void sum_rows(
+    const uint16_t *rows, uint16_t *well_rows, struct RowSums *sums
+) {
+    __m128i inner = _mm_set1_epi16((short)BOARD_INNER_MASK);
+    __m128i pairs = _mm_set1_epi16((short)PAIRS_MASK);
+    __m128i empty = _mm_setzero_si128();
+    __m128i row_trans = _mm_setzero_si128();
+    __m128i column_trans = _mm_setzero_si128();
+
+    for (int y = 0; y < PADDED_ROWS; y += 8) {
+        __m128i row = _mm_loadu_si128((const __m128i *)&rows[y]);
+        __m128i below = _mm_loadu_si128((const __m128i *)&rows[y + 1]);
+        __m128i left = _mm_slli_epi16(row, 1);
+        __m128i right = _mm_srli_epi16(row, 1);
+
+        empty = _mm_add_epi16(empty, popcount16(_mm_andnot_si128(row, inner)));
+        row_trans = _mm_add_epi16(
+            row_trans,
+            popcount16(_mm_and_si128(_mm_xor_si128(row, right), pairs))
+        );
+        column_trans = _mm_add_epi16(
+            column_trans,
+            popcount16(_mm_and_si128(_mm_xor_si128(row, below), inner))
+        );
+        _mm_storeu_si128(
+            (__m128i *)&well_rows[y],
+            _mm_andnot_si128(
+                row, _mm_and_si128(_mm_and_si128(left, right), inner)
+            )
+        );
+    }
+
+    sums->empty_cells = sum16(empty);
+    sums->row_transitions = sum16(row_trans);
+    sums->column_transitions = sum16(column_trans);
+}
+#else
+static void sum_rows(
+    const uint16_t *rows, uint16_t *well_rows, struct RowSums *sums
+) {
+    sums->empty_cells = 0;
+    sums->row_transitions = 0;
+    sums->column_transitions = 0;
+
+    for (int y = 0; y < BOARD_HEIGHT; ++y) {
+        uint32_t row = rows[y];
+        uint32_t left = row << 1;
+        uint32_t right = row >> 1;
+
+        sums->empty_cells += popcount(~row & BOARD_INNER_MASK);
+        sums->row_transitions += popcount((row ^ right) & PAIRS_MASK);
+        sums->column_transitions +=
+            popcount((row ^ rows[y + 1]) & BOARD_INNER_MASK);
+        well_rows[y] = (uint16_t)(~row & left & right & BOARD_INNER_MASK);
+    }
+}
+#endif
+
+#if defined(FEATURES_AVX2) || defined(FEATURES_SSE2)
+/*
+ * Every column keeps the length of its current run of well cells in a byte,
+ * the bits of a row are spread over the bytes for that.
+ */
+static int sum_wells(const uint16_t *well_rows) {
+    const __m128i bits =
+        _mm_set_epi8(-128, 64, 32, 16, 8, 4, 2, 1, -128, 64, 32, 16, 8, 4, 2, 1);
+    __m128i runs = _mm_setzero_si128();
+    __m128i total = _mm_setzero_si128();
+
+    for (int y = 0; y < BOARD_HEIGHT - 1; ++y) {
+        __m128i spread = _mm_unpacklo_epi64(
+            _mm_set1_epi8((char)(well_rows[y] & 0xff)),
+            _mm_set1_epi8((char)(well_rows[y] >> 8))
+        );
+        __m128i wells = _mm_cmpeq_epi8(_mm_and_si128(spread, bits), bits);
+
+        /* Subtracting -1 (all bits set) adds one to the run */
+        runs = _mm_and_si128(_mm_sub_epi8(runs, wells), wells);
+        total = _mm_add_epi8(total, runs);
+    }
+
+    total = _mm_sad_epu8(total, _mm_setzero_si128());
+
+    return _mm_cvtsi128_si32(total) +
+           _mm_cvtsi128_si32(_mm_unpackhi_epi64(total, total));
+}
+#else
+static int sum_wells(const uint16_t *well_rows) {
+    uint8_t runs[BOARD_WIDTH] = {0};
+    int total = 0;
+
+    for (int y = 0; y < BOARD_HEIGHT - 1; ++y) {
+        for (int x = 1; x < BOARD_WIDTH - 1; ++x) {
+            if ((well_rows[y] >> x) & 1u) {
+                total += ++runs[x];
+            } else {
+                runs[x] = 0;
+            }
+        }
+    }
+
+    return total;
+}
+#endif
+
+const char *features_kernel(void) {
+#if defined(FEATURES_AVX2)
+    return "avx2";
+#elif defined(FEATURES_SSE2)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+void features_compute(
+    const struct Board *board, struct BoardFeatures *features
+) {
+    /* +1 for the row below the last one */
+    uint16_t rows[PADDED_ROWS + 1];
+    uint16_t well_rows[PADDED_ROWS];
+
+    memcpy(rows, board->rows, sizeof(board->rows));
+
+    for (int y = BOARD_HEIGHT; y < PADDED_ROWS + 1; ++y) {
+        rows[y] = BOARD_FULL_ROW;
+    }
+
+    struct RowSums sums;
+    sum_rows(rows, well_rows, &sums);
+
+    features->max_height = 0;
+    features->aggregate_height = 0;
+    features->bumpiness = 0;
+
+    for (int x = 0; x < FEATURES_COLUMNS; ++x) {
+        int height = board->heights[x + 1];
+
+        features->heights[x] = (uint8_t)height;
+        features->aggregate_height += height;
+
+        if (height > features->max_height) {
+            features->max_height = height;
+        }
+
+        if (x > 0) {
+            features->bumpiness += abs(height - board->heights[x]);
+        }
+    }
+
+    /* The cells above the surface are the empty cells which aren't holes */
+    features->holes = features->aggregate_height -
+                      (PLAYFIELD_CELLS - sums.empty_cells);
+    features->row_transitions = sums.row_transitions;
+    /* The top edge of the board counts as empty */
+    features->column_transitions =
+        sums.column_transitions + popcount(board->rows[0] & BOARD_INNER_MASK);
+    features->wells = sum_wells(well_rows);
+}
+
+void features_compute_batch(
+    const struct Board *boards, int count, struct BoardFeatures *features
+) {
+    for (int i = 0; i < count; ++i) {
+        features_compute(&boards[i], &features[i]);
+    }
+}
@@ -144,57 +144,58 @@ void font_close(struct Font *self) {
     self->ttf = NULL;
 }
 
-void font_render_char(
-    const struct Font *self, char ch, int x, int y, struct SDL_Color fg
-) {
-    if (!is_ascii(ch)) {
-        return;
-    }
-
-    const SDL_Rect *glyph_rect = &self->glyph_rects[(size_t)ch];
-    SDL_Rect screen_rect = {
-        .x = x,
-        .y = y,
-        .w = glyph_rect->w,
-        .h = glyph_rect->h,
-    };
-
-    SDL_FRect glyph_frect;
-    SDL_FRect screen_frect;
-
-    SDL_RectToFRect(&self->glyph_rects[(size_t)ch], &glyph_frect);
-    SDL_RectToFRect(&screen_rect, &screen_frect);
-
-    SDL_SetTextureColorMod(self->glyph_atlas, fg.r, fg.g, fg.b);
-    SDL_RenderTexture(
-        self->renderer, self->glyph_atlas, &glyph_frect, &screen_frect
-    );
-}
-
-void font_render_str(
-    const struct Font *self, const char *text, int x, int y, struct SDL_Color fg
-) {
-    font_render_str_n(self, text, strlen(text), x, y, fg);
-}
-
-void font_render_str_n(
+int font_build_str_n(
     const struct Font *self, const char *text, size_t len, int x, int y,
-    struct SDL_Color fg
+    struct SDL_Color fg, SDL_Vertex *vertices
 ) {
+    /* The glyphs are white, so the vertex color is the color of the text */
+    SDL_FColor color = {
+        fg.r / 255.0f, fg.g / 255.0f, fg.b / 255.0f, fg.a / 255.0f
+    };
+    const float atlas_size = FONT_MAX_TEXTURE_SIZE;
     int initial_x = x;
+    int count = 0;
 
     for (size_t i = 0; i < len; ++i) {
         char ch = text[i];
 
         if (ch == '\n') {
             x = initial_x;
-            y += TTF_GetFontHeight(self->ttf) + self->line_spacing;
-        } else {
-            font_render_char(self, ch, x, y, fg);
+            y += self->height + self->line_spacing;
+
+            continue;
         }
 
-        x += self->glyph_rects[(size_t)ch].w;
+        if (!is_ascii(ch)) {
+            continue;
+        }
+
+        const SDL_Rect *glyph_rect = &self->glyph_rects[(size_t)ch];
+
+        /* Spaces advance the pen only */
+        if (ch != ' ') {
+            SDL_Vertex *v = &vertices[count * 4];
+            float left = (float)x;
+            float top = (float)y;
+            float right = left + (float)glyph_rect->w;
+            float bottom = top + (float)glyph_rect->h;
+            float u0 = (float)glyph_rect->x / atlas_size;
+            float v0 = (float)glyph_rect->y / atlas_size;
+            float u1 = (float)(glyph_rect->x + glyph_rect->w) / atlas_size;
+            float v1 = (float)(glyph_rect->y + glyph_rect->h) / atlas_size;
+
+            v[0] = (SDL_Vertex){{left, top}, color, {u0, v0}};
+            v[1] = (SDL_Vertex){{right, top}, color, {u1, v0}};
+            v[2] = (SDL_Vertex){{right, bottom}, color, {u1, v1}};
+            v[3] = (SDL_Vertex){{left, bottom}, color, {u0, v1}};
+
+            ++count;
+        }
+
+        x += glyph_rect->w;
     }
+
+    return count;
 }
 
 void font_measure(const struct Font *self, const char *text, int *w, int *h) {
@@ -5,6 +5,7 @@
  */
 
 #include <wetris/game.h>
+#include <wetris/tetrion_view.h>
 #include <wetris/utils.h>
 
 #include <SDL3/SDL.h>
@@ -16,12 +17,140 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+static void apply_action(struct Game *self, enum TetrionAction action) {
+    /* Actions of a versus frame are sent together, a match can't restart */
+    if (self->netplay) {
+        if (action != TETRION_ACTION_START) {
+            self->versus_input |= VERSUS_INPUT(action);
+        }
+
+        return;
+    }
+
+    if (self->record_path &&
+        !replay_record(&self->replay, self->tetrion.time, action)) {
+        log_error("cannot record the game: out of memory");
+        self->record_path = NULL;
+    }
+
+    tetrion_apply(&self->tetrion, action);
+}
+
+static void handle_tetrion_input(struct Game *self) {
+    struct InputState *input = &self->input;
+
+    if (input_key_released(input, SDL_SCANCODE_SPACE)) {
+        apply_action(self, TETRION_ACTION_START);
+    }
+
+    if (input_key_down(input, SDL_SCANCODE_A) ||
+        input_key_down(input, SDL_SCANCODE_LEFT)) {
+        apply_action(self, TETRION_ACTION_MOVE_LEFT);
+    }
+
+    if (input_key_down(input, SDL_SCANCODE_D) ||
+        input_key_down(input, SDL_SCANCODE_RIGHT)) {
+        apply_action(self, TETRION_ACTION_MOVE_RIGHT);
+    }
+
+    if (input_key_released(input, SDL_SCANCODE_E)) {
+        apply_action(self, TETRION_ACTION_ROTATE);
+    }
+
+    if (input_key_released(input, SDL_SCANCODE_Q)) {
+        apply_action(self, TETRION_ACTION_ROTATE_CNT);
+    }
+
+    if (input_key_pressed(input, SDL_SCANCODE_S) ||
+        input_key_pressed(input, SDL_SCANCODE_DOWN)) {
+        apply_action(self, TETRION_ACTION_SOFT_DROP_ON);
+    } else if (input_key_released(input, SDL_SCANCODE_S) ||
+               input_key_released(input, SDL_SCANCODE_DOWN)) {
+        apply_action(self, TETRION_ACTION_SOFT_DROP_OFF);
+    }
+
+    if (input_key_pressed(input, SDL_SCANCODE_SPACE)) {
+        apply_action(self, TETRION_ACTION_HARD_DROP);
+    }
+}
+
+static void handle_tetrion_events(struct Game *self) {
+    struct Tetrion *tetrion = game_tetrion(self);
+    enum TetrionEvent event;
+
+    while (tetrion_poll_event(tetrion, &event)) {
+        /* Every change of the well comes with an event */
+        self->dirty = true;
+
+        switch (event) {
+        case TETRION_EVENT_STARTED:
+            ui_hide_text(&self->ui, TEXT_PRESS_SPACE);
+            sfx_store_play(&self->sfx_store, SFX_LEVEL_UP);
+
+            break;
+        case TETRION_EVENT_RESTARTED:
+            ui_hide_text(&self->ui, TEXT_GAME_OVER);
+            ui_hide_text(&self->ui, TEXT_RETRY_OR_QUIT);
+
+            break;
+        case TETRION_EVENT_MOVED:
+            sfx_store_play(&self->sfx_store, SFX_MOVE);
+
+            break;
+        case TETRION_EVENT_ROTATED:
+            sfx_store_play(&self->sfx_store, SFX_ROTATE);
+
+            break;
+        case TETRION_EVENT_LANDED:
+            sfx_store_play(&self->sfx_store, SFX_LANDED);
+
+            break;
+        case TETRION_EVENT_DROPPED:
+            sfx_store_play(&self->sfx_store, SFX_DROP);
+
+            break;
+        case TETRION_EVENT_ROW_DELETED:
+            sfx_store_play(&self->sfx_store, SFX_DELETED_ROW);
+
+            break;
+        case TETRION_EVENT_LEVEL_UP:
+            sfx_store_play(&self->sfx_store, SFX_LEVEL_UP);
+
+            break;
+        case TETRION_EVENT_SCORE_CHANGED:
+            ui_set_stats(&self->ui, tetrion->score, tetrion->level);
+
+            break;
+        case TETRION_EVENT_NEXT_PIECE:
+            ui_set_preview(
+                &self->ui, tetrion->preview, tetrion->config.preview
+            );
+
+            break;
+        case TETRION_EVENT_GAME_OVER:
+            ui_show_text(&self->ui, TEXT_GAME_OVER);
+
+            if (!self->netplay) {
+                ui_show_text(&self->ui, TEXT_RETRY_OR_QUIT);
+            }
+
+            sfx_store_play(&self->sfx_store, SFX_GAME_OVER);
+
+            break;
+        case TOTAL_TETRION_EVENTS:
+            break;
+        }
+    }
+}
+
 static void handle_input(struct Game *self) {
-    if (self->state == GAME_RUNNING) {
-        tetrion_handle_input(&self->tetrion, &self->input);
+    if (self->state == GAME_RUNNING && !self->replaying) {
+        handle_tetrion_input(self);
     }
 
-    if (input_key_released(&self->input, SDL_SCANCODE_P) &&
+    /* The opponent wouldn't wait */
+    if (!self->netplay &&
+        input_key_released(&self->input, SDL_SCANCODE_P) &&
         (self->state == GAME_RUNNING || self->state == GAME_PAUSED) &&
         (self->tetrion.state == TETRION_STATE_NORMAL ||
          self->tetrion.state == TETRION_STATE_UPDATING_ROWS)) {
@@ -29,7 +158,11 @@ static void handle_input(struct Game *self) {
             self->state = GAME_PAUSED;
 
             ui_show_text(&self->ui, TEXT_PAUSED);
-            tetrion_handle_pause(&self->tetrion);
+
+            /* The key will likely be released while paused */
+            if (!self->replaying) {
+                apply_action(self, TETRION_ACTION_SOFT_DROP_OFF);
+            }
         } else {
             self->state = GAME_RUNNING;
 
@@ -49,29 +182,203 @@ static void handle_event(struct Game *self, const SDL_Event *event) {
     case SDL_EVENT_QUIT:
         self->state = GAME_QUIT;
 
+        break;
+    case SDL_EVENT_RENDER_TARGETS_RESET:
+    case SDL_EVENT_RENDER_DEVICE_RESET:
+        /* The cached wells are lost */
+        for (int i = 0; i < VERSUS_PLAYERS; ++i) {
+            tetrion_view_invalidate(&self->views[i]);
+        }
+
+        self->dirty = true;
+
         break;
     default:
+        /* Exposed, resized, restored... */
+        if (event->type >= SDL_EVENT_WINDOW_FIRST &&
+            event->type <= SDL_EVENT_WINDOW_LAST) {
+            self->dirty = true;
+        }
+
         break;
     }
 }
 
-static void update(struct Game *self) { tetrion_update(&self->tetrion); }
+/*
+ * A versus match advances one frame per frame of the loop, both run at the same
+ * rate. Stalls (waiting for the opponent) just slow the match down.
+ */
+static void update_versus(struct Game *self) {
+    struct Versus *versus = &self->netplay->rollback.versus;
+    int opponent = (self->netplay->rollback.local + 1) % VERSUS_PLAYERS;
+    enum TetrionEvent event;
+
+    if (netplay_update(self->netplay, &self->versus_input)) {
+        self->versus_input = 0;
+    }
+
+    /* Only tell whether the well of the opponent changed */
+    while (tetrion_poll_event(&versus->players[opponent], &event)) {
+        self->dirty = true;
+    }
+
+    if (versus->players[opponent].state == TETRION_STATE_GAME_OVER) {
+        ui_show_text(&self->ui, TEXT_GAME_OVER);
+    }
+}
+
+/*
+ * The tetrion is advanced in fixed ticks, so the outcome doesn't depend on the
+ * frame rate and a replay reproduces the game exactly. The frame time (in ns)
+ * is accumulated and spent a whole tick at a time, the rest carries over.
+ */
+static void update(struct Game *self, Uint64 frame_time) {
+    struct Tetrion *tetrion = &self->tetrion;
+    Uint64 tick_time = SDL_NS_PER_SECOND / tetrion->config.tick_rate;
+    Uint64 max_ticks =
+        SDL_max(tetrion->config.tick_rate * MAX_CATCH_UP / 1000, 1);
+
+    self->tick_acc += frame_time;
+
+    Uint64 ticks = self->tick_acc / tick_time;
+    self->tick_acc %= tick_time;
+
+    /* Don't fast-forward the game after a stall */
+    if (ticks > max_ticks) {
+        ticks = max_ticks;
+    }
+
+    if (self->replaying) {
+        replay_player_advance(&self->player, tetrion, tetrion->time + ticks);
+
+        return;
+    }
+
+    for (Uint64 i = 0; i < ticks; ++i) {
+        tetrion_tick(tetrion);
+    }
+}
+
+static void save_replay(struct Game *self) {
+    replay_finish(&self->replay, self->tetrion.time);
+
+    if (!replay_save(&self->replay, self->record_path)) {
+        log_error("cannot save the replay to '%s'", self->record_path);
+    }
+}
+
+static bool init_netplay(struct Game *self, const struct GameOptions *options) {
+    struct NetAddress host;
+
+    if (options->join_address &&
+        !net_parse_address(options->join_address, &host)) {
+        log_error("invalid address '%s'", options->join_address);
+
+        return false;
+    }
+
+    self->netplay = mem_alloc(sizeof(*self->netplay));
+
+    if (!self->netplay) {
+        return false;
+    }
+
+    bool ok = options->join_address
+                  ? netplay_join(self->netplay, &host, &options->link)
+                  : netplay_host(
+                        self->netplay, options->host_port,
+                        SDL_GetPerformanceCounter(), &options->link
+                    );
+
+    if (!ok) {
+        log_error("cannot open a socket for the match");
+        mem_free(self->netplay);
+        self->netplay = NULL;
+    }
+
+    return ok;
+}
+
+static void deinit_netplay(struct Game *self) {
+    if (self->netplay) {
+        netplay_deinit(self->netplay);
+        mem_free(self->netplay);
+        self->netplay = NULL;
+    }
+}
+
+static bool init_tetrion(struct Game *self, const struct GameOptions *options) {
+    struct TetrionConfig config = tetrion_config_default();
+    config.seed = SDL_GetPerformanceCounter();
+
+    self->record_path = options->record_path;
+    self->replaying = options->replay_path != NULL;
+
+    if (self->replaying) {
+        if (!replay_load(&self->replay, options->replay_path)) {
+            log_error("cannot load the replay '%s'", options->replay_path);
+            replay_init(&self->replay, &config);
+
+            return false;
+        }
+
+        config = self->replay.config;
+        replay_player_init(&self->player, &self->replay);
+
+        /* A replay is never recorded again */
+        self->record_path = NULL;
+    } else {
+        /* Stored in the replay, which is played with it */
+        config.preview = options->preview;
+        replay_init(&self->replay, &config);
+    }
+
+    tetrion_init(&self->tetrion, &config);
+
+    if (options->host_port || options->join_address) {
+        return init_netplay(self, options);
+    }
+
+    return true;
+}
 
 static void render(struct Game *self) {
+    struct TileBatch *batch = &self->tile_batch;
+
     SDL_SetRenderDrawColor(self->renderer, 0x00, 0x00, 0x00, 0xff);
     SDL_RenderClear(self->renderer);
 
     SDL_RenderTextureTiled(self->renderer, self->background, NULL, 1, NULL);
-    tetrion_render(&self->tetrion, self->renderer, &self->tileset);
 
-    ui_render(&self->ui);
+    if (self->netplay) {
+        const struct Rollback *rollback = &self->netplay->rollback;
+        int opponent = (rollback->local + 1) % VERSUS_PLAYERS;
+
+        tetrion_view_render(
+            &self->views[1], &rollback->versus.players[opponent],
+            self->renderer, &self->tileset, batch, TETRION_PADDING_LEFT, 0
+        );
+        tetrion_view_render(
+            &self->views[0], game_tetrion(self), self->renderer,
+            &self->tileset, batch, VERSUS_EXTRA_WIDTH + TETRION_PADDING_LEFT, 0
+        );
+    } else {
+        tetrion_view_render(
+            &self->views[0], &self->tetrion, self->renderer, &self->tileset,
+            batch, TETRION_PADDING_LEFT, 0
+        );
+    }
+
+    ui_render(&self->ui, batch);
+
+    /* The tiles don't overlap the texts, so they can come last */
+    tileset_render_batch(&self->tileset, batch, self->renderer);
 
     SDL_RenderPresent(self->renderer);
 }
 
 static bool init_sdl(void) {
     SDL_SetAppMetadata("wetris", "1.0", "com.inunix3.wetris");
-    SDL_srand(0);
 
     if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO)) {
         log_sdl_error();
@@ -153,6 +460,12 @@ static bool load_assets(struct Game *self) {
         return false;
     }
 
+    for (int i = 0; i < VERSUS_PLAYERS; ++i) {
+        if (!tetrion_view_init(&self->views[i], self->renderer)) {
+            return false;
+        }
+    }
+
     if (!font_store_init(&self->font_store, self->renderer)) {
         return false;
     }
@@ -173,11 +486,27 @@ void game_free(struct Game *self) {
     mem_free(self);
 }
 
-bool game_init(struct Game *self) {
-    self->width = WINDOW_WIDTH;
+bool game_init(struct Game *self, const struct GameOptions *options) {
+    bool versus = options->host_port || options->join_address;
+
+    self->width = WINDOW_WIDTH + (versus ? VERSUS_EXTRA_WIDTH : 0);
     self->height = WINDOW_HEIGHT;
+    self->tick_acc = 0;
+    self->netplay = NULL;
+    self->versus_input = 0;
+    /* Destroyed by game_deinit() even if they were never created */
+    SDL_memset(self->views, 0, sizeof(self->views));
+
+    if (!init_tetrion(self, options)) {
+        replay_deinit(&self->replay);
+
+        return false;
+    }
 
     if (!init_sdl()) {
+        replay_deinit(&self->replay);
+        deinit_netplay(self);
+
         return false;
     }
 
@@ -189,24 +518,14 @@ bool game_init(struct Game *self) {
         goto failure;
     }
 
-    int tetrion_x = TETRION_PADDING_LEFT;
-    int tetrion_y = 0;
-
-    if (!tetrion_init(
-        &self->tetrion, &self->sfx_store, &self->ui, tetrion_x, tetrion_y,
-        TETRION_WIDTH, TETRION_HEIGHT
-    )) {
-        game_deinit(self);
-
-        return NULL;
-    }
-
     self->input = input_new();
+    tile_batch_init(&self->tile_batch);
 
     ui_init(&self->ui, self);
     ui_show_text(&self->ui, TEXT_PRESS_SPACE);
 
     self->state = GAME_RUNNING;
+    self->dirty = true;
 
     return true;
 
@@ -219,11 +538,17 @@ failure:
 
 void game_deinit(struct Game *self) {
     ui_deinit(&self->ui);
-    tetrion_deinit(&self->tetrion);
+    replay_deinit(&self->replay);
+    deinit_netplay(self);
+
     sfx_store_deinit(&self->sfx_store);
     font_store_deinit(&self->font_store);
     tileset_deinit(&self->tileset);
 
+    for (int i = 0; i < VERSUS_PLAYERS; ++i) {
+        tetrion_view_deinit(&self->views[i]);
+    }
+
     SDL_DestroyTexture(self->background);
     self->background = NULL;
 
@@ -238,11 +563,45 @@ void game_deinit(struct Game *self) {
     SDL_Quit();
 }
 
+/*
+ * Whether the scene can change only through input: the game is paused, not
+ * started yet or over. Replays and versus matches always go on.
+ */
+static bool is_idle(const struct Game *self) {
+    if (self->state == GAME_PAUSED) {
+        return true;
+    }
+
+    if (self->replaying || self->netplay) {
+        return false;
+    }
+
+    return self->tetrion.state == TETRION_STATE_NOT_STARTED ||
+           self->tetrion.state == TETRION_STATE_GAME_OVER;
+}
+
 void game_run(struct Game *self) {
     Uint64 dt = 1000 / DEFAULT_FPS;
+    Uint64 last_time = SDL_GetTicksNS();
 
     while (self->state != GAME_QUIT) {
+        /* Instead of redrawing the same frame, sleep until an event comes. The
+         * time spent waiting is dropped like the time spent paused. */
+        if (!self->dirty && !self->ui.dirty && is_idle(self)) {
+            SDL_Event event;
+
+            if (SDL_WaitEventTimeout(&event, IDLE_WAIT)) {
+                handle_event(self, &event);
+            }
+
+            last_time = SDL_GetTicksNS();
+        }
+
         Uint64 start_time = SDL_GetTicks();
+        Uint64 now = SDL_GetTicksNS();
+        Uint64 frame_time = now - last_time;
+
+        last_time = now;
 
         SDL_Event event;
         while (SDL_PollEvent(&event) != 0) {
@@ -252,12 +611,34 @@ void game_run(struct Game *self) {
         input_update(&self->input);
         handle_input(self);
 
-        if (self->state == GAME_RUNNING) {
-            update(self);
+        /* The time spent paused is dropped, so the timers are frozen */
+        if (self->state == GAME_RUNNING && self->netplay) {
+            update_versus(self);
+        } else if (self->state == GAME_RUNNING) {
+            update(self, frame_time);
         }
 
-        render(self);
+        handle_tetrion_events(self);
+
+        if (self->dirty || self->ui.dirty) {
+            render(self);
+            self->dirty = false;
+        }
 
         SDL_DelayPrecise((start_time + dt - SDL_GetTicks()) * 1000000);
     }
+
+    if (self->record_path) {
+        save_replay(self);
+    }
+}
+
+struct Tetrion *game_tetrion(struct Game *self) {
+    if (self->netplay) {
+        struct Rollback *rollback = &self->netplay->rollback;
+
+        return &rollback->versus.players[rollback->local];
+    }
+
+    return &self->tetrion;
 }
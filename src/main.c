@@ -11,17 +11,79 @@
 #include <SDL3/SDL_main.h>
 
 #include <stdlib.h>
+#include <string.h>
 
 /* SDL3 leaks too much, probably because of video drivers or something. */
 const char *__asan_default_options() { return "detect_leaks=false"; }
 
+static bool parse_args(int argc, char *argv[], struct GameOptions *options) {
+    options->record_path = NULL;
+    options->replay_path = NULL;
+    options->preview = DEFAULT_PREVIEW;
+    options->host_port = 0;
+    options->join_address = NULL;
+    options->link = (struct NetplayLink){0};
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            options->record_path = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            options->replay_path = argv[++i];
+        } else if (strcmp(argv[i], "--preview") == 0 && i + 1 < argc) {
+            options->preview = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--host") == 0 && i + 1 < argc) {
+            options->host_port = (uint16_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--join") == 0 && i + 1 < argc) {
+            options->join_address = argv[++i];
+        } else if (strcmp(argv[i], "--lag") == 0 && i + 1 < argc) {
+            options->link.latency = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--loss") == 0 && i + 1 < argc) {
+            options->link.loss = atoi(argv[++i]);
+        } else {
+            log_error(
+                "usage: %s [--record FILE | --replay FILE] [--preview N] "
+                "[--host PORT | --join HOST:PORT] [--lag FRAMES] "
+                "[--loss PERCENT]",
+                argv[0]
+            );
+
+            return false;
+        }
+    }
+
+    if (options->preview < 1 || options->preview > TETRION_MAX_PREVIEW) {
+        log_error("the preview must be 1 to %d pieces", TETRION_MAX_PREVIEW);
+
+        return false;
+    }
+
+    if ((options->host_port || options->join_address) &&
+        (options->record_path || options->replay_path)) {
+        log_error("versus matches can't be recorded or replayed");
+
+        return false;
+    }
+
+    if (options->link.latency < 0 || options->link.loss < 0 ||
+        options->link.loss >= 100) {
+        log_error("the lag can't be negative, the loss must be below 100%%");
+
+        return false;
+    }
+
+    return true;
+}
+
 int main(int argc, char *argv[]) {
-    (void)argc;
-    (void)argv;
+    struct GameOptions options;
+
+    if (!parse_args(argc, argv, &options)) {
+        return EXIT_FAILURE;
+    }
 
     struct Game *game = game_alloc();
 
-    if (!game_init(game)) {
+    if (!game_init(game, &options)) {
         log_error("initialization failed");
 
         return EXIT_FAILURE;
@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <wetris/net.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+typedef SOCKET Socket;
+typedef int SocketLength;
+typedef int SocketSize;
+
+#define close_socket closesocket
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+typedef int Socket;
+typedef socklen_t SocketLength;
+typedef size_t SocketSize;
+
+#define INVALID_SOCKET (-1)
+#define close_socket close
+#endif
+
+static Socket get_socket(const struct NetSocket *self) {
+    return (Socket)self->handle;
+}
+
+static struct sockaddr_in to_sockaddr(const struct NetAddress *address) {
+    struct sockaddr_in sockaddr;
+
+    memset(&sockaddr, 0, sizeof(sockaddr));
+    sockaddr.sin_family = AF_INET;
+    sockaddr.sin_addr.s_addr = htonl(address->host);
+    sockaddr.sin_port = htons(address->port);
+
+    return sockaddr;
+}
+
+static bool set_nonblocking(Socket socket) {
+#ifdef _WIN32
+    u_long enabled = 1;
+
+    return ioctlsocket(socket, FIONBIO, &enabled) == 0;
+#else
+    int flags = fcntl(socket, F_GETFL, 0);
+
+    return flags != -1 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) != -1;
+#endif
+}
+
+bool net_socket_open(struct NetSocket *self, uint16_t port) {
+#ifdef _WIN32
+    WSADATA data;
+
+    /* Every successful call is paired with WSACleanup() on close */
+    if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+        return false;
+    }
+#endif
+
+    Socket sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    struct NetAddress any = {.host = INADDR_ANY, .port = port};
+    struct sockaddr_in address = to_sockaddr(&any);
+
+    if (sock == INVALID_SOCKET) {
+        goto fail;
+    }
+
+    if (bind(sock, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+        !set_nonblocking(sock)) {
+        close_socket(sock);
+
+        goto fail;
+    }
+
+    self->handle = (intptr_t)sock;
+
+    return true;
+
+fail:
+#ifdef _WIN32
+    WSACleanup();
+#endif
+
+    return false;
+}
+
+void net_socket_close(struct NetSocket *self) {
+    close_socket(get_socket(self));
+
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+bool net_send(
+    struct NetSocket *self, const struct NetAddress *to, const void *data,
+    size_t size
+) {
+    struct sockaddr_in address = to_sockaddr(to);
+
+    return sendto(
+               get_socket(self), data, (SocketSize)size, 0,
+               (struct sockaddr *)&address, sizeof(address)
+           ) == (int)size;
+}
+
+int net_receive(
+    struct NetSocket *self, struct NetAddress *from, void *buffer, size_t size
+) {
+    struct sockaddr_in address;
+    SocketLength length = sizeof(address);
+    int received = (int)recvfrom(
+        get_socket(self), buffer, (SocketSize)size, 0,
+        (struct sockaddr *)&address, &length
+    );
+
+    if (received < 0 || address.sin_family != AF_INET) {
+        return -1;
+    }
+
+    from->host = ntohl(address.sin_addr.s_addr);
+    from->port = ntohs(address.sin_port);
+
+    return received;
+}
+
+bool net_parse_address(const char *text, struct NetAddress *address) {
+    const char *colon = strrchr(text, ':');
+    char host[64];
+
+    if (!colon || (size_t)(colon - text) >= sizeof(host)) {
+        return false;
+    }
+
+    memcpy(host, text, (size_t)(colon - text));
+    host[colon - text] = '\0';
+
+    char *end;
+    unsigned long port = strtoul(colon + 1, &end, 10);
+    struct in_addr in;
+
+    if (*end != '\0' || end == colon + 1 || port == 0 || port > UINT16_MAX) {
+        return false;
+    }
+
+    if (strcmp(host, "localhost") == 0) {
+        in.s_addr = htonl(INADDR_LOOPBACK);
+    } else if (inet_pton(AF_INET, host, &in) != 1) {
+        return false;
+    }
+
+    address->host = ntohl(in.s_addr);
+    address->port = (uint16_t)port;
+
+    return true;
+}
@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#include <wetris/netplay.h>
+
+#include <string.h>
+
+/*
+ * Every packet starts with PACKET_MAGIC and a type. The fields are
+ * little-endian:
+ *
+ * HELLO    nothing, sent by the joining side until it's welcomed
+ * WELCOME  the seed of the match, u64
+ * INPUTS   the frames of the peer received so far (the ack) u32, the frame of
+ *          the first input u32, the count u8 and the inputs, a byte each
+ */
+
+#define PACKET_MAGIC "WTVS"
+#define PACKET_HEADER_SIZE 5
+#define INPUTS_HEADER_SIZE (PACKET_HEADER_SIZE + 9)
+#define MAX_INPUTS (NETPLAY_MAX_PACKET - INPUTS_HEADER_SIZE)
+
+enum PacketType {
+    PACKET_HELLO,
+    PACKET_WELCOME,
+    PACKET_INPUTS,
+};
+
+static void put_le(uint8_t **buf, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        *(*buf)++ = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static uint64_t get_le(const uint8_t **buf, int bytes) {
+    uint64_t value = 0;
+
+    for (int i = 0; i < bytes; ++i) {
+        value |= (uint64_t)*(*buf)++ << (8 * i);
+    }
+
+    return value;
+}
+
+static uint8_t *begin_packet(uint8_t *buf, enum PacketType type) {
+    memcpy(buf, PACKET_MAGIC, 4);
+    buf[4] = (uint8_t)type;
+
+    return &buf[PACKET_HEADER_SIZE];
+}
+
+/* Goes through the simulated link, which may drop or delay the packet. */
+static void send_packet(
+    struct Netplay *self, const uint8_t *data, size_t size
+) {
+    const struct NetplayLink *link = &self->link;
+
+    if (link->loss > 0 &&
+        rng_range(&self->link_rng, 100) < (uint32_t)link->loss) {
+        ++self->dropped;
+
+        return;
+    }
+
+    uint64_t delay = (uint64_t)link->latency;
+
+    if (link->jitter > 0) {
+        delay += rng_range(&self->link_rng, (uint32_t)link->jitter + 1);
+    }
+
+    if (delay == 0) {
+        net_send(&self->socket, &self->peer, data, size);
+        ++self->sent;
+
+        return;
+    }
+
+    if (self->delayed_count == NETPLAY_MAX_DELAYED) {
+        ++self->dropped;
+
+        return;
+    }
+
+    struct NetplayPacket *packet = &self->delayed[self->delayed_count++];
+
+    packet->due = self->clock + delay;
+    packet->size = size;
+    memcpy(packet->data, data, size);
+}
+
+static void send_delayed(struct Netplay *self) {
+    int kept = 0;
+
+    for (int i = 0; i < self->delayed_count; ++i) {
+        struct NetplayPacket *packet = &self->delayed[i];
+
+        if (packet->due > self->clock) {
+            self->delayed[kept++] = *packet;
+
+            continue;
+        }
+
+        net_send(&self->socket, &self->peer, packet->data, packet->size);
+        ++self->sent;
+    }
+
+    self->delayed_count = kept;
+}
+
+static void send_hello(struct Netplay *self) {
+    uint8_t buf[PACKET_HEADER_SIZE];
+
+    begin_packet(buf, PACKET_HELLO);
+    send_packet(self, buf, sizeof(buf));
+}
+
+static void send_welcome(struct Netplay *self) {
+    uint8_t buf[PACKET_HEADER_SIZE + 8];
+    uint8_t *pos = begin_packet(buf, PACKET_WELCOME);
+
+    put_le(&pos, self->rollback.versus.players[0].config.seed, 8);
+    send_packet(self, buf, sizeof(buf));
+}
+
+static void send_inputs(struct Netplay *self) {
+    uint8_t buf[NETPLAY_MAX_PACKET];
+    uint8_t inputs[MAX_INPUTS];
+    uint64_t first;
+    int count = rollback_unacked(&self->rollback, &first, inputs, MAX_INPUTS);
+    uint8_t *pos = begin_packet(buf, PACKET_INPUTS);
+
+    put_le(&pos, (uint32_t)self->rollback.remote_frames, 4);
+    put_le(&pos, (uint32_t)first, 4);
+    put_le(&pos, (uint8_t)count, 1);
+    memcpy(pos, inputs, (size_t)count);
+    send_packet(self, buf, INPUTS_HEADER_SIZE + (size_t)count);
+}
+
+static bool same_address(
+    const struct NetAddress *a, const struct NetAddress *b
+) {
+    return a->host == b->host && a->port == b->port;
+}
+
+static void handle_packet(
+    struct Netplay *self, const struct NetAddress *from, const uint8_t *data,
+    size_t size
+) {
+    if (size < PACKET_HEADER_SIZE || memcmp(data, PACKET_MAGIC, 4) != 0) {
+        return;
+    }
+
+    const uint8_t *pos = &data[PACKET_HEADER_SIZE];
+    bool connecting = self->state == NETPLAY_STATE_CONNECTING;
+
+    /* The host takes the first one saying hello as its peer */
+    if (!(self->host && connecting) && !same_address(from, &self->peer)) {
+        return;
+    }
+
+    switch ((enum PacketType)data[4]) {
+    case PACKET_HELLO:
+        if (!self->host) {
+            break;
+        }
+
+        /* Said again if the welcome got lost */
+        self->peer = *from;
+        self->state = NETPLAY_STATE_PLAYING;
+        send_welcome(self);
+
+        break;
+    case PACKET_WELCOME:
+        if (self->host || !connecting || size < PACKET_HEADER_SIZE + 8) {
+            break;
+        }
+
+        rollback_init(&self->rollback, get_le(&pos, 8), 1);
+        self->state = NETPLAY_STATE_PLAYING;
+
+        break;
+    case PACKET_INPUTS: {
+        if (connecting || size < INPUTS_HEADER_SIZE) {
+            break;
+        }
+
+        uint64_t ack = get_le(&pos, 4);
+        uint64_t first = get_le(&pos, 4);
+        int count = (int)get_le(&pos, 1);
+
+        if (size < INPUTS_HEADER_SIZE + (size_t)count) {
+            break;
+        }
+
+        rollback_ack(&self->rollback, ack);
+        rollback_add_remote(&self->rollback, first, pos, count);
+
+        break;
+    }
+    }
+}
+
+static void init(
+    struct Netplay *self, bool host, const struct NetplayLink *link
+) {
+    self->host = host;
+    self->state = NETPLAY_STATE_CONNECTING;
+    memset(&self->link, 0, sizeof(self->link));
+
+    if (link) {
+        self->link = *link;
+    }
+
+    rng_seed(&self->link_rng, host ? 1 : 2);
+    self->delayed_count = 0;
+    self->clock = 0;
+    self->sent = 0;
+    self->dropped = 0;
+    self->received = 0;
+}
+
+bool netplay_host(
+    struct Netplay *self, uint16_t port, uint64_t seed,
+    const struct NetplayLink *link
+) {
+    if (!net_socket_open(&self->socket, port)) {
+        return false;
+    }
+
+    init(self, true, link);
+    rollback_init(&self->rollback, seed, 0);
+
+    return true;
+}
+
+bool netplay_join(
+    struct Netplay *self, const struct NetAddress *host,
+    const struct NetplayLink *link
+) {
+    if (!net_socket_open(&self->socket, 0)) {
+        return false;
+    }
+
+    init(self, false, link);
+    self->peer = *host;
+    /* Replaced once the host tells the seed */
+    rollback_init(&self->rollback, 0, 1);
+
+    return true;
+}
+
+void netplay_deinit(struct Netplay *self) {
+    net_socket_close(&self->socket);
+}
+
+bool netplay_update(struct Netplay *self, const uint8_t *input) {
+    uint8_t buf[NETPLAY_MAX_PACKET];
+    struct NetAddress from;
+    int size;
+
+    ++self->clock;
+
+    while ((size = net_receive(&self->socket, &from, buf, sizeof(buf))) >= 0) {
+        ++self->received;
+        handle_packet(self, &from, buf, (size_t)size);
+    }
+
+    send_delayed(self);
+
+    if (self->state == NETPLAY_STATE_CONNECTING) {
+        if (!self->host) {
+            send_hello(self);
+        }
+
+        return false;
+    }
+
+    bool advanced = false;
+
+    if (input) {
+        advanced = rollback_advance(&self->rollback, *input);
+    } else {
+        rollback_resimulate(&self->rollback);
+    }
+
+    send_inputs(self);
+
+    return advanced;
+}
@@ -6,378 +6,257 @@
 
 #include <wetris/piece.h>
 
-#include <string.h>
+#define ROW(a, b, c, d) ((a) | (b) << 1 | (c) << 2 | (d) << 3)
+#define SHAPE(r0, r1, r2, r3)                                                  \
+    ((uint16_t)((r0) | (r1) << 4 | (r2) << 8 | (r3) << 12))
 
 /* clang-format off */
-static const bool g_pieces[TOTAL_PIECES][4][PIECE_HEIGHT][PIECE_WIDTH] = {
+const uint16_t g_piece_masks[TOTAL_PIECES][4] = {
     {
         /* Z - red */
-        {
-            {1, 1, 0, 0},
-            {0, 1, 1, 0},
-            {0, 0, 0, 0},
-            {0, 0, 0, 0}
-        },
-        {
-            {0, 0, 1, 0},
-            {0, 1, 1, 0},
-            {0, 1, 0, 0},
-            {0, 0, 0, 0}
-        },
-        {
-            {0, 0, 0, 0},
-            {1, 1, 0, 0},
-            {0, 1, 1, 0},
-            {0, 0, 0, 0}
-        },
-        {
-            {0, 1, 0, 0},
-            {1, 1, 0, 0},
-            {1, 0, 0, 0},
-            {0, 0, 0, 0}
-        }
+        SHAPE(
+            ROW(1, 1, 0, 0),
+            ROW(0, 1, 1, 0),
+            ROW(0, 0, 0, 0),
+            ROW(0, 0, 0, 0)
+        ),
+        SHAPE(
+            ROW(0, 0, 1, 0),
+            ROW(0, 1, 1, 0),
+            ROW(0, 1, 0, 0),
+            ROW(0, 0, 0, 0)
+        ),
+        SHAPE(
+            ROW(0, 0, 0, 0),
+            ROW(1, 1, 0, 0),
+            ROW(0, 1, 1, 0),
+            ROW(0, 0, 0, 0)
+        ),
+        SHAPE(
+            ROW(0, 1, 0, 0),
+            ROW(1, 1, 0, 0),
+            ROW(1, 0, 0, 0),
+            ROW(0, 0, 0, 0)
+        )
     },
     {
         /* L - orange */
-        {
-            {0, 0, 1, 0},
-            {1, 1, 1, 0},
-            {0, 0, 0, 0},
-            {0, 0, 0, 0}
-        },
-        {
-            {0, 1, 0, 0},
-            {0, 1, 0, 0},
-            {0, 1, 1, 0},
-            {0, 0, 0, 0}
-        },
-        {
-            {0, 0, 0, 0},
-            {1, 1, 1, 0},
-            {1, 0, 0, 0},
-            {0, 0, 0, 0}
-        },
-        {
-            {1, 1, 0, 0},
-            {0, 1, 0, 0},
-            {0, 1, 0, 0},
-            {0, 0, 0, 0}
-        }
+        SHAPE(
+            ROW(0, 0, 1, 0),
+            ROW(1, 1, 1, 0),
+            ROW(0, 0, 0, 0),
+            ROW(0, 0, 0, 0)
+        ),
+        SHAPE(
+            ROW(0, 1, 0, 0),
+            ROW(0, 1, 0, 0),
+            ROW(0, 1, 1, 0),
+            ROW(0, 0, 0, 0)
+        ),
+        SHAPE(
+            ROW(0, 0, 0, 0),
+            ROW(1, 1, 1, 0),
+            ROW(1, 0, 0, 0),
+            ROW(0, 0, 0, 0)
+        ),
+        SHAPE(
+            ROW(1, 1, 0, 0),
+            ROW(0, 1, 0, 0),
+            ROW(0, 1, 0, 0),
+            ROW(0, 0, 0, 0)
+        )
     },
     {
         /* O - yellow */
-        {
-            {0, 1, 1, 0},
-            {0, 1, 1, 0},
-            {0, 0, 0, 0},
-            {0, 0, 0, 0}
-        },
-        {
-            {0, 1, 1, 0},
-            {0, 1, 1, 0},
-            {0, 0, 0, 0},
-            {0, 0, 0, 0}
-        },
-        {
-            {0, 1, 1, 0},
-            {0, 1, 1, 0},
-            {0, 0, 0, 0},
-            {0, 0, 0, 0}
-        },
-        {
-            {0, 1, 1, 0},
-            {0, 1, 1, 0},
-            {0, 0, 0, 0},
-            {0, 0, 0, 0}
-        }
+        SHAPE(
+            ROW(0, 1, 1, 0),
+            ROW(0, 1, 1, 0),
+            ROW(0, 0, 0, 0),
+            ROW(0, 0, 0, 0)
+        ),
+        SHAPE(
+            ROW(0, 1, 1, 0),
+            ROW(0, 1, 1, 0),
+            ROW(0, 0, 0, 0),
+            ROW(0, 0, 0, 0)
+        ),
+        SHAPE(
+            ROW(0, 1, 1, 0),
+            ROW(0, 1, 1, 0),
+            ROW(0, 0, 0, 0),
+            ROW(0, 0, 0, 0)
+        ),
+        SHAPE(
+            ROW(0, 1, 1, 0),
+            ROW(0, 1, 1, 0),
+            ROW(0, 0, 0, 0),
+            ROW(0, 0, 0, 0)
+        )
     },
     {
         /* S - green */
-        {
-            {0, 1, 1, 0},
-            {1, 1, 0, 0},
-            {0, 0, 0, 0},
-            {0, 0, 0, 0}
-        },
-        {
-            {0, 1, 0, 0},
-            {0, 1, 1, 0},
-            {0, 0, 1, 0},
-            {0, 0, 0, 0}
-        },
-        {
-            {0, 0, 0, 0},
-            {0, 1, 1, 0},
-            {1, 1, 0, 0},
-            {0, 0, 0, 0}
-        },
-        {
-            {1, 0, 0, 0},
-            {1, 1, 0, 0},
-            {0, 1, 0, 0},
-            {0, 0, 0, 0}
-        }
+        SHAPE(
+            ROW(0, 1, 1, 0),
+            ROW(1, 1, 0, 0),
+            ROW(0, 0, 0, 0),
+            ROW(0, 0, 0, 0)
+        ),
+        SHAPE(
+            ROW(0, 1, 0, 0),
+            ROW(0, 1, 1, 0),
+            ROW(0, 0, 1, 0),
+            ROW(0, 0, 0, 0)
+        ),
+        SHAPE(
+            ROW(0, 0, 0, 0),
+            ROW(0, 1, 1, 0),
+            ROW(1, 1, 0, 0),
+            ROW(0, 0, 0, 0)
+        ),
+        SHAPE(
+            ROW(1, 0, 0, 0),
+            ROW(1, 1, 0, 0),
+            ROW(0, 1, 0, 0),
+            ROW(0, 0, 0, 0)
+        )
     },
     {
         /* J - blue */
-        {
-            {1, 0, 0, 0},
-            {1, 1, 1, 0},
-            {0, 0, 0, 0},
-            {0, 0, 0, 0}
-        },
-        {
-            {0, 1, 1, 0},
-            {0, 1, 0, 0},
-            {0, 1, 0, 0},
-            {0, 0, 0, 0}
-        },
-        {
-            {0, 0, 0, 0},
-            {1, 1, 1, 0},
-            {0, 0, 1, 0},
-            {0, 0, 0, 0}
-        },
-        {
-            {0, 1, 0, 0},
-            {0, 1, 0, 0},
-            {1, 1, 0, 0},
-            {0, 0, 0, 0}
-        }
+        SHAPE(
+            ROW(1, 0, 0, 0),
+            ROW(1, 1, 1, 0),
+            ROW(0, 0, 0, 0),
+            ROW(0, 0, 0, 0)
+        ),
+        SHAPE(
+            ROW(0, 1, 1, 0),
+            ROW(0, 1, 0, 0),
+            ROW(0, 1, 0, 0),
+            ROW(0, 0, 0, 0)
+        ),
+        SHAPE(
+            ROW(0, 0, 0, 0),
+            ROW(1, 1, 1, 0),
+            ROW(0, 0, 1, 0),
+            ROW(0, 0, 0, 0)
+        ),
+        SHAPE(
+            ROW(0, 1, 0, 0),
+            ROW(0, 1, 0, 0),
+            ROW(1, 1, 0, 0),
+            ROW(0, 0, 0, 0)
+        )
     },
     {
         /* I - cyan */
-        {
-            {0, 0, 0, 0},
-            {1, 1, 1, 1},
-            {0, 0, 0, 0},
-            {0, 0, 0, 0}
-        },
-        {
-            {0, 0, 1, 0},
-            {0, 0, 1, 0},
-            {0, 0, 1, 0},
-            {0, 0, 1, 0}
-        },
-        {
-            {0, 0, 0, 0},
-            {0, 0, 0, 0},
-            {1, 1, 1, 1},
-            {0, 0, 0, 0}
-        },
-        {
-            {0, 1, 0, 0},
-            {0, 1, 0, 0},
-            {0, 1, 0, 0},
-            {0, 1, 0, 0}
-        }
+        SHAPE(
+            ROW(0, 0, 0, 0),
+            ROW(1, 1, 1, 1),
+            ROW(0, 0, 0, 0),
+            ROW(0, 0, 0, 0)
+        ),
+        SHAPE(
+            ROW(0, 0, 1, 0),
+            ROW(0, 0, 1, 0),
+            ROW(0, 0, 1, 0),
+            ROW(0, 0, 1, 0)
+        ),
+        SHAPE(
+            ROW(0, 0, 0, 0),
+            ROW(0, 0, 0, 0),
+            ROW(1, 1, 1, 1),
+            ROW(0, 0, 0, 0)
+        ),
+        SHAPE(
+            ROW(0, 1, 0, 0),
+            ROW(0, 1, 0, 0),
+            ROW(0, 1, 0, 0),
+            ROW(0, 1, 0, 0)
+        )
     },
     {
         /* T - purple */
-        {
-            {0, 1, 0, 0},
-            {1, 1, 1, 0},
-            {0, 0, 0, 0},
-            {0, 0, 0, 0}
-        },
-        {
-            {0, 1, 0, 0},
-            {0, 1, 1, 0},
-            {0, 1, 0, 0},
-            {0, 0, 0, 0}
-        },
-        {
-            {0, 0, 0, 0},
-            {1, 1, 1, 0},
-            {0, 1, 0, 0},
-            {0, 0, 0, 0}
-        },
-        {
-            {0, 1, 0, 0},
-            {1, 1, 0, 0},
-            {0, 1, 0, 0},
-            {0, 0, 0, 0}
-        }
+        SHAPE(
+            ROW(0, 1, 0, 0),
+            ROW(1, 1, 1, 0),
+            ROW(0, 0, 0, 0),
+            ROW(0, 0, 0, 0)
+        ),
+        SHAPE(
+            ROW(0, 1, 0, 0),
+            ROW(0, 1, 1, 0),
+            ROW(0, 1, 0, 0),
+            ROW(0, 0, 0, 0)
+        ),
+        SHAPE(
+            ROW(0, 0, 0, 0),
+            ROW(1, 1, 1, 0),
+            ROW(0, 1, 0, 0),
+            ROW(0, 0, 0, 0)
+        ),
+        SHAPE(
+            ROW(0, 1, 0, 0),
+            ROW(1, 1, 0, 0),
+            ROW(0, 1, 0, 0),
+            ROW(0, 0, 0, 0)
+        )
     },
 };
 /* clang-format on */
 
-/* Kick offsets for J, L, S, T, Z tetrominos */
-static struct SDL_Point g_kick_offs[4][5] = {
-    // 0 -> 90
-    {{0, 0}, {-1, 0}, {-1, 1}, {0, -2}, {-1, -2}},
-
-    // 90 -> 180
-    {{0, 0}, {1, 0}, {1, -1}, {0, 2}, {1, 2}},
-
-    // 180 -> 270
-    {{0, 0}, {1, 0}, {1, 1}, {0, -2}, {1, -2}},
-
-    // 270 -> 0
-    {{0, 0}, {-1, 0}, {-1, -1}, {0, 2}, {-1, 2}}
-};
-
-/* Kick offsets for J, L, S, T, Z tetrominos */
-static struct SDL_Point g_kick_offs_cnt[4][5] = {
-    // 90 -> 0
-    {{0, 0}, {1, 0}, {1, -1}, {0, 2}, {1, 2}},
-
-    // 180 -> 90
-    {{0, 0}, {-1, 0}, {-1, 1}, {0, -2}, {-1, -2}},
-
-    // 270 -> 180
-    {{0, 0}, {-1, 0}, {-1, -1}, {0, 2}, {-1, 2}},
-
-    // 0 -> 270
-    {{0, 0}, {1, 0}, {1, 1}, {0, -2}, {1, -2}}
-};
-
-/* Kick offsets for I tetromino */
-static struct SDL_Point g_i_kick_offs[4][5] = {
-    // 0 -> 90
-    {{0, 0}, {-2, 0}, {1, 0}, {-2, -1}, {1, 2}},
-
-    // 90 -> 180
-    {{0, 0}, {-1, 0}, {2, 0}, {-1, 2}, {2, -1}},
-
-    // 180 -> 270
-    {{0, 0}, {2, 0}, {-1, 0}, {2, 1}, {-1, -2}},
-
-    // 270 -> 0
-    {{0, 0}, {1, 0}, {-2, 0}, {1, -2}, {-2, 1}}
-};
-
-/* Kick offsets for I tetromino */
-static struct SDL_Point g_i_kick_offs_cnt[4][5] = {
-    // 90 -> 0
-    {{0, 0}, {2, 0}, {-1, 0}, {2, 1}, {-1, -2}},
-
-    // 180 -> 90
-    {{0, 0}, {1, 0}, {-2, 0}, {1, -2}, {-2, 1}},
-
-    // 270 -> 180
-    {{0, 0}, {-2, 0}, {1, 0}, {-2, -1}, {1, 2}},
+/* clang-format off */
 
-    // 0 -> 270
-    {{0, 0}, {-1, 0}, {2, 0}, {-1, 2}, {2, -1}}
-};
+/*
+ * Offsets to try when a rotated piece doesn't fit (SRS). Rotation 0 is the
+ * spawn state, 1 is the state after a clockwise rotation and so on. The offsets
+ * are absolute, i.e. every test starts from the original position.
+ */
 
-static enum TileId piece_tile(enum PieceId id) {
-    switch (id) {
-    case PIECE_Z:
-        return TILE_RED;
-    case PIECE_L:
-        return TILE_ORANGE;
-    case PIECE_O:
-        return TILE_YELLOW;
-    case PIECE_S:
-        return TILE_GREEN;
-    case PIECE_J:
-        return TILE_BLUE;
-    case PIECE_I:
-        return TILE_CYAN;
-    case PIECE_T:
-        return TILE_PURPLE;
-    case TOTAL_PIECES:
-        /* doesn't make sense, but what else can we do? */
-        return TOTAL_TILES;
+/* J, L, S, T, Z tetrominos */
+#define KICK_OFFS                                                              \
+    {                                                                          \
+        [0][1] = {{0, 0}, {-1, 0}, {-1, -1}, {0, 2}, {-1, 2}},                 \
+        [1][0] = {{0, 0}, {1, 0}, {1, 1}, {0, -2}, {1, -2}},                   \
+        [1][2] = {{0, 0}, {1, 0}, {1, 1}, {0, -2}, {1, -2}},                   \
+        [2][1] = {{0, 0}, {-1, 0}, {-1, -1}, {0, 2}, {-1, 2}},                 \
+        [2][3] = {{0, 0}, {1, 0}, {1, -1}, {0, 2}, {1, 2}},                    \
+        [3][2] = {{0, 0}, {-1, 0}, {-1, 1}, {0, -2}, {-1, -2}},                \
+        [3][0] = {{0, 0}, {-1, 0}, {-1, 1}, {0, -2}, {-1, -2}},                \
+        [0][3] = {{0, 0}, {1, 0}, {1, -1}, {0, 2}, {1, 2}},                    \
     }
-}
-
-static void update_tilemap(struct Piece *self) {
-    memset(self->tilemap, TILE_NULL, sizeof(self->tilemap));
 
-    for (int y = 0; y < PIECE_HEIGHT; ++y) {
-        for (int x = 0; x < PIECE_WIDTH; ++x) {
-            enum TileId *tile = &self->tilemap[y][x];
-
-            if (self->tiles[y][x]) {
-                *tile = self->tile;
-            } else {
-                *tile = TILE_NULL;
-            }
-        }
+/* I tetromino */
+#define I_KICK_OFFS                                                            \
+    {                                                                          \
+        [0][1] = {{0, 0}, {-2, 0}, {1, 0}, {-2, 1}, {1, -2}},                  \
+        [1][0] = {{0, 0}, {2, 0}, {-1, 0}, {2, -1}, {-1, 2}},                  \
+        [1][2] = {{0, 0}, {-1, 0}, {2, 0}, {-1, -2}, {2, 1}},                  \
+        [2][1] = {{0, 0}, {1, 0}, {-2, 0}, {1, 2}, {-2, -1}},                  \
+        [2][3] = {{0, 0}, {2, 0}, {-1, 0}, {2, -1}, {-1, 2}},                  \
+        [3][2] = {{0, 0}, {-2, 0}, {1, 0}, {-2, 1}, {1, -2}},                  \
+        [3][0] = {{0, 0}, {1, 0}, {-2, 0}, {1, 2}, {-2, -1}},                  \
+        [0][3] = {{0, 0}, {-1, 0}, {2, 0}, {-1, -2}, {2, 1}},                  \
     }
-}
 
-struct Piece piece_new(enum PieceId id) {
-    struct Piece piece;
-
-    piece.id = id;
-    piece.tile = piece_tile(id);
-    piece.prev_rotation = 0;
-    piece.rotation = 0;
-    memcpy(piece.tiles, g_pieces[id][0], sizeof(piece.tiles));
-    piece.pos = (SDL_Point){0, 0};
-    piece.kick_offs = id == PIECE_I ? &g_i_kick_offs[0][0] : &g_kick_offs[0][0];
+/* O doesn't need to be kicked, all tests are just {0, 0}. */
+const struct KickOff g_kick_offs[TOTAL_PIECES][PIECE_ROTATIONS][PIECE_ROTATIONS]
+                                [PIECE_KICK_TESTS] = {
+    [PIECE_Z] = KICK_OFFS,
+    [PIECE_L] = KICK_OFFS,
+    [PIECE_O] = {{{{0, 0}}}},
+    [PIECE_S] = KICK_OFFS,
+    [PIECE_J] = KICK_OFFS,
+    [PIECE_I] = I_KICK_OFFS,
+    [PIECE_T] = KICK_OFFS,
+};
+/* clang-format on */
 
-    update_tilemap(&piece);
+struct Piece piece_new(enum PieceId id) {
+    struct Piece piece = {
+        .id = id,
+        .rotation = 0,
+        .pos = {0, 0},
+    };
 
     return piece;
 }
-
-void piece_rotate_90(struct Piece *self) {
-    self->prev_rotation = self->rotation;
-
-    if (self->rotation == 3) {
-        self->rotation = 0;
-    } else {
-        ++self->rotation;
-    }
-
-    if (self->id == PIECE_I) {
-        self->kick_offs = &g_kick_offs[self->rotation][0];
-    } else {
-        self->kick_offs = &g_kick_offs_cnt[self->rotation][0];
-    }
-
-    memcpy(
-        self->tiles, g_pieces[self->id][self->rotation], sizeof(self->tiles)
-    );
-    update_tilemap(self);
-}
-
-void piece_rotate_90_cnt(struct Piece *self) {
-    self->prev_rotation = self->rotation;
-
-    if (self->rotation == 0) {
-        self->rotation = 3;
-    } else {
-        --self->rotation;
-    }
-
-    if (self->id == PIECE_I) {
-        self->kick_offs = &g_i_kick_offs[self->rotation][0];
-    } else {
-        self->kick_offs = &g_i_kick_offs_cnt[self->rotation][0];
-    }
-
-    memcpy(
-        self->tiles, g_pieces[self->id][self->rotation], sizeof(self->tiles)
-    );
-    update_tilemap(self);
-}
-
-struct SDL_Point piece_get_kick_off(struct Piece *self, int idx) {
-    if (self->id == PIECE_I) {
-        return g_i_kick_offs[self->rotation][idx];
-    } else {
-        return g_kick_offs[self->rotation][idx];
-    }
-}
-
-void piece_render(
-    struct Piece *self, SDL_Renderer *renderer, struct TileSet *tileset,
-    struct SDL_Point pos
-) {
-    for (int y = 0; y < PIECE_HEIGHT; ++y) {
-        for (int x = 0; x < PIECE_WIDTH; ++x) {
-            int tile_x = pos.x + x * TILE_WIDTH;
-            int tile_y = pos.y + y * TILE_HEIGHT;
-
-            tileset_render_tile(
-                tileset, renderer, self->tilemap[y][x], tile_x, tile_y
-            );
-        }
-    }
-}
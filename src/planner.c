@@ -0,0 +1,330 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#include <wetris/planner.h>
+#include <wetris/clock.h>
+
+#include <float.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_BEAM_WIDTH 16
+#define DEFAULT_DEPTH 2
+
+/* Keeps the scores of boards apart from the look-ahead scores of the bot */
+#define BOARD_KEY 0x6a09e667f3bcc909u
+
+struct PlannerRank {
+    double score;
+    uint32_t index; /* of the child */
+};
+
+/* Best first, ties are broken by the order of the children. */
+static int compare_ranks(const void *a, const void *b) {
+    const struct PlannerRank *rank_a = a;
+    const struct PlannerRank *rank_b = b;
+
+    if (rank_a->score != rank_b->score) {
+        return rank_a->score > rank_b->score ? -1 : 1;
+    }
+
+    return rank_a->index < rank_b->index ? -1 : rank_a->index > rank_b->index;
+}
+
+static struct PlannerNode *node_children(const struct Planner *self, int i) {
+    return &self->children[(size_t)i * BOT_MAX_LANDINGS];
+}
+
+/* Scores the board without the deleted rows, which are added linearly. */
+static double board_score(
+    const struct Planner *self, const struct Board *board
+) {
+    uint64_t key = board->hash ^ self->salt ^ BOARD_KEY;
+    uint64_t bits;
+    double score;
+
+    if (self->table && trans_table_probe(self->table, key, &bits)) {
+        memcpy(&score, &bits, sizeof(score));
+
+        return score;
+    }
+
+    struct BoardFeatures features;
+
+    features_compute(board, &features);
+    score = bot_evaluate(&features, 0, &self->config.weights);
+
+    if (self->table) {
+        memcpy(&bits, &score, sizeof(bits));
+        trans_table_store(self->table, key, bits);
+    }
+
+    return score;
+}
+
+/* Places the piece on the board of the node in every possible way. */
+static int expand(
+    const struct Planner *self, struct BotLandings *landings,
+    const struct PlannerNode *node, struct PlannerNode *children
+) {
+    const struct BotWeights *weights = &self->config.weights;
+
+    bot_landings_find(landings, &node->board, &self->piece);
+
+    for (int i = 0; i < landings->count; ++i) {
+        const struct Piece *piece = &landings->landings[i].piece;
+        struct PlannerNode *child = &children[i];
+
+        child->board = node->board;
+        child->lines = node->lines + bot_place(&child->board, piece);
+        child->root = node->root;
+        child->score = board_score(self, &child->board) +
+                       weights->lines * child->lines;
+    }
+
+    return landings->count;
+}
+
+/*
+ * At the last depth only the best child of the node counts, so it's found by
+ * the look-ahead of the bot. The child keeps the board of the node, which
+ * isn't used anymore but keeps the children of different nodes apart.
+ */
+static int expand_best(
+    const struct Planner *self, struct BotLandings *landings,
+    const struct PlannerNode *node, struct PlannerNode *child
+) {
+    const struct BotWeights *weights = &self->config.weights;
+    double score = bot_look_ahead(
+        landings, &node->board, &self->piece, weights, self->table, self->salt
+    );
+
+    if (score == -DBL_MAX) {
+        return 0;
+    }
+
+    child->board = node->board;
+    child->lines = node->lines;
+    child->root = node->root;
+    child->score = score + weights->lines * node->lines;
+
+    return 1;
+}
+
+static void expand_job(void *ctx, int index, int worker) {
+    struct Planner *self = ctx;
+
+    self->child_counts[index] = 0;
+
+    /* Once the time is up the rest of the depth is thrown away anyway */
+    if (atomic_load_explicit(&self->expired, memory_order_relaxed)) {
+        return;
+    }
+
+    if (self->deadline && clock_ns() >= self->deadline) {
+        atomic_store_explicit(&self->expired, true, memory_order_relaxed);
+
+        return;
+    }
+
+    struct BotLandings *landings = &self->scratch[worker];
+    const struct PlannerNode *node = &self->beam[index];
+    struct PlannerNode *children = node_children(self, index);
+
+    self->child_counts[index] =
+        self->last ? expand_best(self, landings, node, children)
+                   : expand(self, landings, node, children);
+}
+
+/* The landings of the current piece are the roots of the whole search. */
+static void expand_root(struct Planner *self, const struct Tetrion *tetrion) {
+    struct PlannerNode *children = node_children(self, 0);
+    struct BotPlacement placement;
+
+    self->beam[0].board = tetrion->board;
+    self->beam[0].score = 0;
+    self->beam[0].lines = 0;
+    self->beam[0].root = -1;
+    self->beam_size = 1;
+    self->piece = tetrion->piece;
+    self->last = false;
+    self->child_counts[0] = expand(self, &self->root, &self->beam[0], children);
+
+    for (int i = 0; i < self->child_counts[0]; ++i) {
+        /* The landings which the bot cannot input are left out */
+        children[i].root =
+            bot_landings_inputs(&self->root, i, &placement) ? i : -1;
+    }
+}
+
+static bool in_beam(
+    const struct Planner *self, int size, const struct Board *board
+) {
+    for (int i = 0; i < size; ++i) {
+        const struct Board *other = &self->beam[i].board;
+
+        if (other->hash == board->hash &&
+            memcmp(other->rows, board->rows, sizeof(board->rows)) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* Replaces the beam with the best children, returns how many were kept. */
+static int select_beam(struct Planner *self) {
+    size_t count = 0;
+
+    for (int i = 0; i < self->beam_size; ++i) {
+        const struct PlannerNode *children = node_children(self, i);
+
+        for (int j = 0; j < self->child_counts[i]; ++j) {
+            if (children[j].root < 0) {
+                continue;
+            }
+
+            self->ranks[count].score = children[j].score;
+            self->ranks[count].index = (uint32_t)(i * BOT_MAX_LANDINGS + j);
+            ++count;
+        }
+    }
+
+    qsort(self->ranks, count, sizeof(*self->ranks), compare_ranks);
+
+    int size = 0;
+
+    for (size_t i = 0; i < count && size < self->config.beam_width; ++i) {
+        const struct PlannerNode *child = &self->children[self->ranks[i].index];
+
+        /* The same board reached in different ways is kept once */
+        if (!in_beam(self, size, &child->board)) {
+            self->beam[size++] = *child;
+        }
+    }
+
+    return size;
+}
+
+struct PlannerConfig planner_config_default(void) {
+    struct PlannerConfig config = {
+        .weights = bot_weights_default(),
+        .beam_width = DEFAULT_BEAM_WIDTH,
+        .depth = DEFAULT_DEPTH,
+        .budget = 0,
+    };
+
+    return config;
+}
+
+bool planner_init(
+    struct Planner *self, struct Pool *pool, const struct PlannerConfig *config
+) {
+    size_t width = (size_t)(config->beam_width > 0 ? config->beam_width : 1);
+    size_t children = width * BOT_MAX_LANDINGS;
+
+    self->config = *config;
+    self->config.beam_width = (int)width;
+    self->pool = pool;
+    self->table = NULL;
+    self->salt = bot_weights_key(&config->weights);
+    self->scratch = malloc((size_t)pool->size * sizeof(*self->scratch));
+    self->beam = malloc(width * sizeof(*self->beam));
+    self->beam_size = 0;
+    self->children = malloc(children * sizeof(*self->children));
+    self->child_counts = malloc(width * sizeof(*self->child_counts));
+    self->ranks = malloc(children * sizeof(*self->ranks));
+    self->deadline = 0;
+    atomic_init(&self->expired, false);
+    self->searches = 0;
+    self->depth_total = 0;
+
+    if (!self->scratch || !self->beam || !self->children ||
+        !self->child_counts || !self->ranks) {
+        planner_deinit(self);
+
+        return false;
+    }
+
+    return true;
+}
+
+void planner_deinit(struct Planner *self) {
+    free(self->scratch);
+    free(self->beam);
+    free(self->children);
+    free(self->child_counts);
+    free(self->ranks);
+
+    self->scratch = NULL;
+    self->beam = NULL;
+    self->children = NULL;
+    self->child_counts = NULL;
+    self->ranks = NULL;
+}
+
+bool planner_search(
+    struct Planner *self, const struct Tetrion *tetrion,
+    struct BotPlacement *best
+) {
+    if (tetrion->state != TETRION_STATE_NORMAL) {
+        return false;
+    }
+
+    int depth = self->config.depth;
+
+    if (depth > 1 + tetrion->config.preview) {
+        depth = 1 + tetrion->config.preview;
+    }
+
+    self->deadline = self->config.budget ? clock_ns() + self->config.budget : 0;
+    atomic_store(&self->expired, false);
+
+    /* The first depth is always completed, so there's always a placement */
+    expand_root(self, tetrion);
+
+    int completed = 0;
+    int root = -1;
+    double score = -DBL_MAX;
+
+    for (;;) {
+        int size = select_beam(self);
+
+        if (size == 0) {
+            break;
+        }
+
+        self->beam_size = size;
+        root = self->beam[0].root;
+        score = self->beam[0].score;
+
+        if (++completed == depth) {
+            break;
+        }
+
+        self->piece = tetrion->preview[completed - 1];
+        self->last = completed + 1 == depth;
+        pool_run(self->pool, self->beam_size, expand_job, self);
+
+        if (atomic_load(&self->expired)) {
+            break;
+        }
+    }
+
+    ++self->searches;
+    self->depth_total += (uint64_t)completed;
+
+    if (root < 0 || !bot_landings_inputs(&self->root, root, best)) {
+        return false;
+    }
+
+    struct Board board = tetrion->board;
+
+    best->lines = bot_place(&board, &best->piece);
+    best->score = score;
+
+    return true;
+}
@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <wetris/pool.h>
+
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <malloc.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+static uint64_t make_range(uint32_t begin, uint32_t end) {
+    return (uint64_t)end << 32 | begin;
+}
+
+static uint32_t range_begin(uint64_t range) {
+    return (uint32_t)range;
+}
+
+static uint32_t range_end(uint64_t range) {
+    return (uint32_t)(range >> 32);
+}
+
+static bool pop(struct PoolWorker *self, int *index) {
+    uint64_t range = atomic_load(&self->range);
+
+    for (;;) {
+        uint32_t begin = range_begin(range);
+        uint32_t end = range_end(range);
+
+        if (begin >= end) {
+            return false;
+        }
+
+        if (atomic_compare_exchange_weak(
+                &self->range, &range, make_range(begin + 1, end)
+            )) {
+            *index = (int)begin;
+
+            return true;
+        }
+    }
+}
+
+/* Moves the upper half of the victim's indices to the thief. */
+static bool steal(struct PoolWorker *thief, struct PoolWorker *victim) {
+    uint64_t range = atomic_load(&victim->range);
+
+    for (;;) {
+        uint32_t begin = range_begin(range);
+        uint32_t end = range_end(range);
+
+        if (begin >= end) {
+            return false;
+        }
+
+        uint32_t middle = begin + (end - begin) / 2;
+
+        if (atomic_compare_exchange_weak(
+                &victim->range, &range, make_range(begin, middle)
+            )) {
+            atomic_store(&thief->range, make_range(middle, end));
+
+            return true;
+        }
+    }
+}
+
+static bool find_work(struct PoolWorker *self, int *index) {
+    struct Pool *pool = self->pool;
+
+    for (;;) {
+        if (pop(self, index)) {
+            return true;
+        }
+
+        bool stolen = false;
+
+        for (int i = 1; i < pool->size && !stolen; ++i) {
+            stolen = steal(self, &pool->workers[(self->id + i) % pool->size]);
+        }
+
+        /* No new indices appear during a run, so everything is taken */
+        if (!stolen) {
+            return false;
+        }
+    }
+}
+
+static int work(void *arg) {
+    struct PoolWorker *self = arg;
+    struct Pool *pool = self->pool;
+    uint64_t generation = 0;
+
+    for (;;) {
+        mtx_lock(&pool->lock);
+
+        while (!pool->quit && pool->generation == generation) {
+            cnd_wait(&pool->wake, &pool->lock);
+        }
+
+        if (pool->quit) {
+            mtx_unlock(&pool->lock);
+
+            return 0;
+        }
+
+        generation = pool->generation;
+        mtx_unlock(&pool->lock);
+
+        int index;
+
+        while (find_work(self, &index)) {
+            pool->job(pool->ctx, index, self->id);
+        }
+
+        mtx_lock(&pool->lock);
+
+        if (--pool->running == 0) {
+            cnd_signal(&pool->idle);
+        }
+
+        mtx_unlock(&pool->lock);
+    }
+}
+
+static struct PoolWorker *alloc_workers(int count) {
+    size_t size = (size_t)count * sizeof(struct PoolWorker);
+
+#ifdef _WIN32
+    return _aligned_malloc(size, _Alignof(struct PoolWorker));
+#else
+    return aligned_alloc(_Alignof(struct PoolWorker), size);
+#endif
+}
+
+static void free_workers(struct PoolWorker *workers) {
+#ifdef _WIN32
+    _aligned_free(workers);
+#else
+    free(workers);
+#endif
+}
+
+int pool_cpu_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+
+    return (int)info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return count > 0 ? (int)count : 1;
+#endif
+}
+
+bool pool_init(struct Pool *self, int size) {
+    self->size = size > 0 ? size : pool_cpu_count();
+    self->workers = alloc_workers(self->size);
+    self->generation = 0;
+    self->running = 0;
+    self->quit = false;
+    self->job = NULL;
+    self->ctx = NULL;
+
+    if (!self->workers) {
+        return false;
+    }
+
+    if (mtx_init(&self->lock, mtx_plain) != thrd_success) {
+        free_workers(self->workers);
+
+        return false;
+    }
+
+    cnd_init(&self->wake);
+    cnd_init(&self->idle);
+
+    for (int i = 0; i < self->size; ++i) {
+        struct PoolWorker *worker = &self->workers[i];
+
+        worker->pool = self;
+        worker->id = i;
+        atomic_init(&worker->range, 0);
+
+        if (thrd_create(&worker->thread, work, worker) != thrd_success) {
+            /* Run with the workers that did start */
+            self->size = i;
+
+            break;
+        }
+    }
+
+    if (self->size == 0) {
+        pool_deinit(self);
+
+        return false;
+    }
+
+    return true;
+}
+
+void pool_deinit(struct Pool *self) {
+    if (!self->workers) {
+        return;
+    }
+
+    mtx_lock(&self->lock);
+    self->quit = true;
+    cnd_broadcast(&self->wake);
+    mtx_unlock(&self->lock);
+
+    for (int i = 0; i < self->size; ++i) {
+        thrd_join(self->workers[i].thread, NULL);
+    }
+
+    cnd_destroy(&self->wake);
+    cnd_destroy(&self->idle);
+    mtx_destroy(&self->lock);
+    free_workers(self->workers);
+    self->workers = NULL;
+}
+
+void pool_run(struct Pool *self, int count, PoolJob job, void *ctx) {
+    if (count <= 0) {
+        return;
+    }
+
+    uint32_t share = (uint32_t)count / (uint32_t)self->size;
+    uint32_t extra = (uint32_t)count % (uint32_t)self->size;
+    uint32_t begin = 0;
+
+    for (int i = 0; i < self->size; ++i) {
+        uint32_t end = begin + share + ((uint32_t)i < extra);
+
+        atomic_store(&self->workers[i].range, make_range(begin, end));
+        begin = end;
+    }
+
+    mtx_lock(&self->lock);
+    self->job = job;
+    self->ctx = ctx;
+    self->running = self->size;
+    ++self->generation;
+    cnd_broadcast(&self->wake);
+
+    while (self->running > 0) {
+        cnd_wait(&self->idle, &self->lock);
+    }
+
+    mtx_unlock(&self->lock);
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#include <wetris/randomizer.h>
+
+#include <string.h>
+
+static void refill_bag(struct Randomizer *self) {
+    for (uint8_t i = 0; i < TOTAL_PIECES; ++i) {
+        self->bag[i] = i;
+    }
+
+    /* Fisher-Yates */
+    for (uint32_t i = TOTAL_PIECES - 1; i > 0; --i) {
+        uint32_t j = rng_range(&self->rng, i + 1);
+        uint8_t tmp = self->bag[i];
+
+        self->bag[i] = self->bag[j];
+        self->bag[j] = tmp;
+    }
+
+    self->bag_left = TOTAL_PIECES;
+}
+
+void randomizer_init(
+    struct Randomizer *self, enum RandomizerKind kind, uint64_t seed
+) {
+    rng_seed(&self->rng, seed);
+    self->kind = kind;
+    /* Unused, but copied into snapshots */
+    memset(self->bag, 0, sizeof(self->bag));
+    self->bag_left = 0;
+}
+
+enum PieceId randomizer_next(struct Randomizer *self) {
+    switch (self->kind) {
+    case RANDOMIZER_RANDOM:
+        break;
+    case RANDOMIZER_BAG:
+        if (self->bag_left == 0) {
+            refill_bag(self);
+        }
+
+        return (enum PieceId)self->bag[--self->bag_left];
+    }
+
+    return (enum PieceId)rng_range(&self->rng, TOTAL_PIECES);
+}
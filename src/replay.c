@@ -0,0 +1,737 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <wetris/replay.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*
+ * A replay file consists of:
+ *
+ * header     HEADER_SIZE bytes, the configuration (see replay_save())
+ * actions    the entries as recorded
+ * keyframes  encoded snapshots (see encode_keyframe()), 8-byte aligned
+ * index      an entry per keyframe ordered by time: the tick, where the actions
+ *            continue, the time of the action before that and the offset of
+ *            the keyframe, 8 bytes each
+ * footer     the offset of the index, the keyframe count and FOOTER_MAGIC
+ *
+ * Version 1 had only the first 40 bytes of the header and the actions, the
+ * keyframes of version 2 lacked the deleted rows and are ignored.
+ */
+
+#define ACTION_BITS 3
+#define V1_HEADER_SIZE 40
+#define HEADER_SIZE 64
+#define INDEX_ENTRY_SIZE 32
+#define FOOTER_SIZE 16
+#define FOOTER_MAGIC "WTIX"
+#define ALIGNMENT 8
+
+#define KEYFRAME_FIXED_SIZE (58 + TETRION_MAX_PREVIEW + TOTAL_PIECES)
+#define KEYFRAME_ROW_SIZE 6
+#define KEYFRAME_MAX_SIZE                                                      \
+    (KEYFRAME_FIXED_SIZE + (BOARD_HEIGHT - 1) * KEYFRAME_ROW_SIZE)
+
+_Static_assert(
+    TOTAL_TETRION_ACTIONS <= (1 << ACTION_BITS), "actions don't fit in a replay"
+);
+
+static bool reserve(struct Replay *self, size_t size) {
+    if (self->size + size <= self->capacity) {
+        return true;
+    }
+
+    size_t new_capacity = self->capacity ? self->capacity * 2 : 256;
+
+    while (new_capacity < self->size + size) {
+        new_capacity *= 2;
+    }
+
+    uint8_t *buffer = realloc(self->buffer, new_capacity);
+
+    if (!buffer) {
+        return false;
+    }
+
+    self->buffer = buffer;
+    self->actions = buffer;
+    self->capacity = new_capacity;
+
+    return true;
+}
+
+/* Writes the value as little-endian and moves past it. */
+static void put_le(uint8_t **buf, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; ++i) {
+        (*buf)[i] = (uint8_t)(value >> (8 * i));
+    }
+
+    *buf += bytes;
+}
+
+static uint64_t get_le(const uint8_t **buf, int bytes) {
+    uint64_t value = 0;
+
+    for (int i = 0; i < bytes; ++i) {
+        value |= (uint64_t)(*buf)[i] << (8 * i);
+    }
+
+    *buf += bytes;
+
+    return value;
+}
+
+/* Sections may be empty, and their data NULL then. */
+static bool write_all(FILE *file, const void *data, size_t size) {
+    return size == 0 || fwrite(data, 1, size, file) == size;
+}
+
+static size_t align(size_t offset) {
+    return (offset + ALIGNMENT - 1) & ~(size_t)(ALIGNMENT - 1);
+}
+
+static bool read_varint(
+    const uint8_t *data, size_t size, size_t *pos, uint64_t *value
+) {
+    *value = 0;
+
+    for (int shift = 0; *pos < size && shift < 64; shift += 7) {
+        uint8_t byte = data[(*pos)++];
+
+        *value |= (uint64_t)(byte & 0x7f) << shift;
+
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void fetch_next(struct ReplayPlayer *self) {
+    const struct Replay *replay = self->replay;
+    uint64_t entry;
+
+    self->entry_pos = self->pos;
+    self->base_time = self->time;
+
+    if (!read_varint(replay->actions, replay->size, &self->pos, &entry)) {
+        self->done = true;
+
+        return;
+    }
+
+    self->time += entry >> ACTION_BITS;
+    self->action =
+        (enum TetrionAction)(entry & ((1u << ACTION_BITS) - 1));
+}
+
+/*
+ * The board is the compact part: only the rows from the topmost block down are
+ * stored, as the occupancy and the colors of each.
+ */
+static size_t encode_keyframe(
+    const struct TetrionSnapshot *snapshot, uint8_t *buf
+) {
+    uint8_t *pos = buf;
+    int top = 0;
+
+    while (top < BOARD_HEIGHT - 1 && snapshot->rows[top] == BOARD_EMPTY_ROW) {
+        ++top;
+    }
+
+    put_le(&pos, snapshot->time, 8);
+
+    for (int i = 0; i < 4; ++i) {
+        put_le(&pos, snapshot->rng.s[i], 4);
+    }
+
+    put_le(&pos, (uint32_t)snapshot->score, 4);
+    put_le(&pos, snapshot->lines, 4);
+    put_le(&pos, snapshot->ticker_elapsed, 4);
+    put_le(&pos, snapshot->clear_timer_elapsed, 4);
+    put_le(&pos, snapshot->fall_interval, 4);
+    put_le(&pos, snapshot->saved_fall_interval, 4);
+    put_le(&pos, snapshot->level, 2);
+    put_le(&pos, (uint8_t)snapshot->piece_x, 1);
+    put_le(&pos, (uint8_t)snapshot->piece_y, 1);
+    put_le(&pos, snapshot->piece_id, 1);
+    put_le(&pos, snapshot->piece_rotation, 1);
+    put_le(&pos, snapshot->state, 1);
+    put_le(&pos, snapshot->bag_left, 1);
+    put_le(&pos, snapshot->flags, 1);
+
+    for (int i = 0; i < TETRION_MAX_PREVIEW; ++i) {
+        put_le(&pos, snapshot->preview[i], 1);
+    }
+
+    for (int i = 0; i < TOTAL_PIECES; ++i) {
+        put_le(&pos, snapshot->bag[i], 1);
+    }
+
+    put_le(&pos, (uint8_t)top, 1);
+
+    for (int y = top; y < BOARD_HEIGHT - 1; ++y) {
+        put_le(&pos, snapshot->rows[y], 2);
+        put_le(&pos, snapshot->colors[y], 4);
+    }
+
+    return (size_t)(pos - buf);
+}
+
+static bool decode_keyframe(
+    const uint8_t *data, size_t size, struct TetrionSnapshot *snapshot
+) {
+    if (size < KEYFRAME_FIXED_SIZE) {
+        return false;
+    }
+
+    const uint8_t *pos = data;
+
+    memset(snapshot, 0, sizeof(*snapshot));
+    snapshot->time = get_le(&pos, 8);
+
+    for (int i = 0; i < 4; ++i) {
+        snapshot->rng.s[i] = (uint32_t)get_le(&pos, 4);
+    }
+
+    snapshot->score = (int32_t)(uint32_t)get_le(&pos, 4);
+    snapshot->lines = (uint32_t)get_le(&pos, 4);
+    snapshot->ticker_elapsed = (uint32_t)get_le(&pos, 4);
+    snapshot->clear_timer_elapsed = (uint32_t)get_le(&pos, 4);
+    snapshot->fall_interval = (uint32_t)get_le(&pos, 4);
+    snapshot->saved_fall_interval = (uint32_t)get_le(&pos, 4);
+    snapshot->level = (uint16_t)get_le(&pos, 2);
+    snapshot->piece_x = (int8_t)(uint8_t)get_le(&pos, 1);
+    snapshot->piece_y = (int8_t)(uint8_t)get_le(&pos, 1);
+    snapshot->piece_id = (uint8_t)get_le(&pos, 1);
+    snapshot->piece_rotation = (uint8_t)get_le(&pos, 1);
+    snapshot->state = (uint8_t)get_le(&pos, 1);
+    snapshot->bag_left = (uint8_t)get_le(&pos, 1);
+    snapshot->flags = (uint8_t)get_le(&pos, 1);
+
+    for (int i = 0; i < TETRION_MAX_PREVIEW; ++i) {
+        snapshot->preview[i] = (uint8_t)get_le(&pos, 1);
+    }
+
+    for (int i = 0; i < TOTAL_PIECES; ++i) {
+        snapshot->bag[i] = (uint8_t)get_le(&pos, 1);
+    }
+
+    int top = (int)get_le(&pos, 1);
+
+    if (top > BOARD_HEIGHT - 1 ||
+        size < KEYFRAME_FIXED_SIZE +
+                   (size_t)(BOARD_HEIGHT - 1 - top) * KEYFRAME_ROW_SIZE) {
+        return false;
+    }
+
+    for (int y = 0; y < top; ++y) {
+        snapshot->rows[y] = BOARD_EMPTY_ROW;
+    }
+
+    for (int y = top; y < BOARD_HEIGHT - 1; ++y) {
+        snapshot->rows[y] = (uint16_t)get_le(&pos, 2);
+        snapshot->colors[y] = (uint32_t)get_le(&pos, 4);
+    }
+
+    return tetrion_snapshot_valid(snapshot);
+}
+
+struct Keyframes {
+    uint8_t *data;
+    size_t size;
+    uint8_t *index;
+    uint32_t count;
+};
+
+/* Plays the replay and takes a keyframe every interval. */
+static bool build_keyframes(
+    const struct Replay *self, uint64_t interval, size_t offset,
+    struct Keyframes *keyframes
+) {
+    uint64_t count = self->duration / interval;
+
+    keyframes->data = NULL;
+    keyframes->size = 0;
+    keyframes->index = NULL;
+    keyframes->count = 0;
+
+    /* Played with the current rules, the game could differ from the recorded
+     * one, so such replays get no keyframes */
+    if (count == 0 || self->rules_version != TETRION_RULES_VERSION) {
+        return true;
+    }
+
+    if (count > UINT32_MAX) {
+        return false;
+    }
+
+    keyframes->data = malloc((size_t)count * KEYFRAME_MAX_SIZE);
+    keyframes->index = malloc((size_t)count * INDEX_ENTRY_SIZE);
+
+    if (!keyframes->data || !keyframes->index) {
+        free(keyframes->data);
+        free(keyframes->index);
+
+        return false;
+    }
+
+    struct Tetrion tetrion;
+    struct ReplayPlayer player;
+
+    tetrion_init(&tetrion, &self->config);
+    replay_player_init(&player, self);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        uint64_t time = (i + 1) * interval;
+        struct TetrionSnapshot snapshot;
+        uint8_t *entry = &keyframes->index[(size_t)i * INDEX_ENTRY_SIZE];
+
+        replay_player_advance(&player, &tetrion, time);
+        tetrion_snapshot(&tetrion, &snapshot);
+
+        put_le(&entry, time, 8);
+        put_le(&entry, player.entry_pos, 8);
+        put_le(&entry, player.base_time, 8);
+        put_le(&entry, offset + keyframes->size, 8);
+
+        keyframes->size +=
+            encode_keyframe(&snapshot, &keyframes->data[keyframes->size]);
+    }
+
+    keyframes->count = (uint32_t)count;
+
+    return true;
+}
+
+#ifndef _WIN32
+static bool map_file(const char *path, const uint8_t **file, size_t *size) {
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    void *data = MAP_FAILED;
+
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        *size = (size_t)st.st_size;
+        data = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+
+    close(fd);
+
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    *file = data;
+
+    return true;
+}
+#endif
+
+static void release_file(const uint8_t *file, size_t size, bool mapped) {
+#ifndef _WIN32
+    if (mapped) {
+        munmap((void *)file, size);
+
+        return;
+    }
+#else
+    (void)size;
+    (void)mapped;
+#endif
+
+    free((void *)file);
+}
+
+static bool read_file(const char *path, const uint8_t **file, size_t *size) {
+    FILE *stream = fopen(path, "rb");
+
+    if (!stream) {
+        return false;
+    }
+
+    long length = -1;
+
+    if (fseek(stream, 0, SEEK_END) == 0) {
+        length = ftell(stream);
+    }
+
+    uint8_t *data = length > 0 ? malloc((size_t)length) : NULL;
+    bool ok = data && fseek(stream, 0, SEEK_SET) == 0 &&
+              fread(data, 1, (size_t)length, stream) == (size_t)length;
+
+    fclose(stream);
+
+    if (!ok) {
+        free(data);
+
+        return false;
+    }
+
+    *file = data;
+    *size = (size_t)length;
+
+    return true;
+}
+
+/* Checks the layout of the file, the keyframes are checked when used. */
+static bool parse(struct Replay *self, const uint8_t *file, size_t size) {
+    if (size < V1_HEADER_SIZE || memcmp(file, REPLAY_MAGIC, 4) != 0) {
+        return false;
+    }
+
+    const uint8_t *pos = &file[4];
+    int version = (int)get_le(&pos, 1);
+    struct TetrionConfig config = tetrion_config_default();
+
+    config.randomizer = (enum RandomizerKind)get_le(&pos, 1);
+
+    /* Replays recorded before the tick rate was stored ran at 1 kHz */
+    uint32_t tick_rate = (uint32_t)get_le(&pos, 2);
+
+    if (tick_rate) {
+        config.tick_rate = tick_rate;
+    }
+
+    config.seed = get_le(&pos, 8);
+    config.clear_delay = get_le(&pos, 8);
+
+    uint64_t duration = get_le(&pos, 8);
+    uint64_t actions_size = get_le(&pos, 8);
+    size_t header_size = V1_HEADER_SIZE;
+    int rules_version = 1;
+
+    if (version == 2 || version == REPLAY_VERSION) {
+        if (size < HEADER_SIZE) {
+            return false;
+        }
+
+        rules_version = (int)get_le(&pos, 2);
+
+        int width = (int)get_le(&pos, 1);
+        int height = (int)get_le(&pos, 1);
+
+        config.preview = (int)get_le(&pos, 1);
+        pos += 3;
+        config.scoring.row_deleted = (int32_t)(uint32_t)get_le(&pos, 4);
+        config.scoring.landed = (int32_t)(uint32_t)get_le(&pos, 4);
+        config.scoring.move = (int32_t)(uint32_t)get_le(&pos, 4);
+        header_size = HEADER_SIZE;
+
+        if (width != BOARD_WIDTH - 2 || height != BOARD_HEIGHT - 1 ||
+            config.preview < 1 || config.preview > TETRION_MAX_PREVIEW) {
+            return false;
+        }
+    } else if (version != 1) {
+        return false;
+    }
+
+    if (actions_size > size - header_size) {
+        return false;
+    }
+
+    replay_init(self, &config);
+    self->duration = duration;
+    self->rules_version = rules_version;
+    self->actions = &file[header_size];
+    self->size = (size_t)actions_size;
+
+    if (version < REPLAY_VERSION) {
+        return true;
+    }
+
+    if (size - header_size - self->size < FOOTER_SIZE) {
+        return false;
+    }
+
+    const uint8_t *footer = &file[size - FOOTER_SIZE];
+    uint64_t index_offset = get_le(&footer, 8);
+    uint64_t count = get_le(&footer, 4);
+
+    if (memcmp(footer, FOOTER_MAGIC, 4) != 0 ||
+        index_offset < header_size + self->size ||
+        index_offset > size - FOOTER_SIZE ||
+        (size - FOOTER_SIZE - index_offset) != count * INDEX_ENTRY_SIZE) {
+        return false;
+    }
+
+    self->index = &file[index_offset];
+    self->keyframe_count = (uint32_t)count;
+
+    return true;
+}
+
+/* Restores the last keyframe at or before the time, if there's one. */
+static bool restore_keyframe(
+    struct ReplayPlayer *self, struct Tetrion *tetrion, uint64_t time
+) {
+    const struct Replay *replay = self->replay;
+
+    /* Keyframes fit only the configuration they were taken with */
+    if (replay->keyframe_count == 0 ||
+        replay->rules_version != TETRION_RULES_VERSION ||
+        tetrion->config.preview != replay->config.preview) {
+        return false;
+    }
+
+    uint32_t low = 0;
+    uint32_t high = replay->keyframe_count;
+
+    /* The number of keyframes at or before the time */
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        const uint8_t *entry = &replay->index[(size_t)mid * INDEX_ENTRY_SIZE];
+
+        if (get_le(&entry, 8) <= time) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    if (low == 0) {
+        return false;
+    }
+
+    const uint8_t *entry = &replay->index[(size_t)(low - 1) * INDEX_ENTRY_SIZE];
+    uint64_t keyframe_time = get_le(&entry, 8);
+    uint64_t entry_pos = get_le(&entry, 8);
+    uint64_t base_time = get_le(&entry, 8);
+    uint64_t offset = get_le(&entry, 8);
+    size_t index_offset = (size_t)(replay->index - replay->file);
+    struct TetrionSnapshot snapshot;
+
+    /* Playing on is cheaper when the tetrion is already past the keyframe */
+    if (tetrion->time <= time && tetrion->time >= keyframe_time) {
+        return false;
+    }
+
+    if (entry_pos > replay->size || offset >= index_offset ||
+        !decode_keyframe(
+            &replay->file[offset], index_offset - (size_t)offset, &snapshot
+        ) ||
+        snapshot.time != keyframe_time) {
+        return false;
+    }
+
+    tetrion_restore(tetrion, &snapshot);
+    self->pos = (size_t)entry_pos;
+    self->time = base_time;
+    self->done = false;
+    fetch_next(self);
+
+    return true;
+}
+
+void replay_init(struct Replay *self, const struct TetrionConfig *config) {
+    self->config = *config;
+    self->duration = 0;
+    self->rules_version = TETRION_RULES_VERSION;
+    self->actions = NULL;
+    self->size = 0;
+    self->buffer = NULL;
+    self->capacity = 0;
+    self->last_time = 0;
+    self->file = NULL;
+    self->file_size = 0;
+    self->mapped = false;
+    self->index = NULL;
+    self->keyframe_count = 0;
+}
+
+void replay_deinit(struct Replay *self) {
+    if (!self) {
+        return;
+    }
+
+    release_file(self->file, self->file_size, self->mapped);
+    free(self->buffer);
+    replay_init(self, &self->config);
+}
+
+bool replay_record(
+    struct Replay *self, uint64_t time, enum TetrionAction action
+) {
+    if (!reserve(self, 10)) {
+        return false;
+    }
+
+    uint64_t entry = (time - self->last_time) << ACTION_BITS | action;
+
+    do {
+        uint8_t byte = entry & 0x7f;
+
+        entry >>= 7;
+        self->buffer[self->size++] = entry ? byte | 0x80 : byte;
+    } while (entry);
+
+    self->last_time = time;
+    self->duration = time;
+
+    return true;
+}
+
+void replay_finish(struct Replay *self, uint64_t time) {
+    self->duration = time;
+}
+
+bool replay_save(const struct Replay *self, const char *path) {
+    const struct TetrionConfig *config = &self->config;
+
+    if (config->tick_rate > UINT16_MAX) {
+        return false;
+    }
+
+    size_t keyframes_offset = align(HEADER_SIZE + self->size);
+    struct Keyframes keyframes;
+
+    if (!build_keyframes(
+            self, (uint64_t)REPLAY_KEYFRAME_INTERVAL * config->tick_rate,
+            keyframes_offset, &keyframes
+        )) {
+        return false;
+    }
+
+    size_t index_offset = align(keyframes_offset + keyframes.size);
+    uint8_t header[HEADER_SIZE] = {0};
+    uint8_t footer[FOOTER_SIZE];
+    uint8_t padding[ALIGNMENT] = {0};
+    uint8_t *pos = header;
+
+    memcpy(pos, REPLAY_MAGIC, 4);
+    pos += 4;
+    put_le(&pos, REPLAY_VERSION, 1);
+    put_le(&pos, (uint8_t)config->randomizer, 1);
+    put_le(&pos, config->tick_rate, 2);
+    put_le(&pos, config->seed, 8);
+    put_le(&pos, config->clear_delay, 8);
+    put_le(&pos, self->duration, 8);
+    put_le(&pos, self->size, 8);
+    put_le(&pos, (uint16_t)self->rules_version, 2);
+    put_le(&pos, BOARD_WIDTH - 2, 1);
+    put_le(&pos, BOARD_HEIGHT - 1, 1);
+    put_le(&pos, (uint8_t)config->preview, 1);
+    pos += 3;
+    put_le(&pos, (uint32_t)config->scoring.row_deleted, 4);
+    put_le(&pos, (uint32_t)config->scoring.landed, 4);
+    put_le(&pos, (uint32_t)config->scoring.move, 4);
+
+    pos = footer;
+    put_le(&pos, index_offset, 8);
+    put_le(&pos, keyframes.count, 4);
+    memcpy(pos, FOOTER_MAGIC, 4);
+
+    FILE *file = fopen(path, "wb");
+    bool ok = file != NULL;
+
+    if (ok) {
+        size_t index_size = (size_t)keyframes.count * INDEX_ENTRY_SIZE;
+        size_t keyframes_padding =
+            keyframes_offset - (HEADER_SIZE + self->size);
+        size_t index_padding =
+            index_offset - (keyframes_offset + keyframes.size);
+
+        ok = write_all(file, header, HEADER_SIZE) &&
+             write_all(file, self->actions, self->size) &&
+             write_all(file, padding, keyframes_padding) &&
+             write_all(file, keyframes.data, keyframes.size) &&
+             write_all(file, padding, index_padding) &&
+             write_all(file, keyframes.index, index_size) &&
+             write_all(file, footer, FOOTER_SIZE);
+        ok = fclose(file) == 0 && ok;
+    }
+
+    free(keyframes.data);
+    free(keyframes.index);
+
+    return ok;
+}
+
+bool replay_load(struct Replay *self, const char *path) {
+    const uint8_t *file = NULL;
+    size_t size = 0;
+    bool mapped = false;
+
+#ifndef _WIN32
+    mapped = map_file(path, &file, &size);
+#endif
+
+    if (!mapped && !read_file(path, &file, &size)) {
+        return false;
+    }
+
+    if (!parse(self, file, size)) {
+        release_file(file, size, mapped);
+
+        return false;
+    }
+
+    self->file = file;
+    self->file_size = size;
+    self->mapped = mapped;
+
+    return true;
+}
+
+void replay_player_init(
+    struct ReplayPlayer *self, const struct Replay *replay
+) {
+    self->replay = replay;
+    self->pos = 0;
+    self->time = 0;
+    self->done = false;
+
+    fetch_next(self);
+}
+
+void replay_player_advance(
+    struct ReplayPlayer *self, struct Tetrion *tetrion, uint64_t time
+) {
+    for (;;) {
+        while (!self->done && self->time <= tetrion->time) {
+            tetrion_apply(tetrion, self->action);
+            fetch_next(self);
+        }
+
+        if (tetrion->time >= time) {
+            break;
+        }
+
+        tetrion_tick(tetrion);
+    }
+}
+
+void replay_player_seek(
+    struct ReplayPlayer *self, struct Tetrion *tetrion, uint64_t time
+) {
+    if (!restore_keyframe(self, tetrion, time) && time < tetrion->time) {
+        struct TetrionConfig config = tetrion->config;
+
+        tetrion_init(tetrion, &config);
+        replay_player_init(self, self->replay);
+    }
+
+    replay_player_advance(self, tetrion, time);
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#include <wetris/rng.h>
+
+static uint32_t rotl(uint32_t x, int k) { return (x << k) | (x >> (32 - k)); }
+
+static uint64_t splitmix64(uint64_t *state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15u);
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9u;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebu;
+
+    return z ^ (z >> 31);
+}
+
+void rng_seed(struct Rng *self, uint64_t seed) {
+    /* xoshiro must not be seeded with all zeros, splitmix64 never yields them
+     * twice in a row. */
+    uint64_t a = splitmix64(&seed);
+    uint64_t b = splitmix64(&seed);
+
+    self->s[0] = (uint32_t)a;
+    self->s[1] = (uint32_t)(a >> 32);
+    self->s[2] = (uint32_t)b;
+    self->s[3] = (uint32_t)(b >> 32);
+}
+
+uint32_t rng_next(struct Rng *self) {
+    uint32_t *s = self->s;
+    uint32_t result = rotl(s[1] * 5, 7) * 9;
+    uint32_t t = s[1] << 9;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+
+    s[2] ^= t;
+    s[3] = rotl(s[3], 11);
+
+    return result;
+}
+
+uint64_t rng_next64(struct Rng *self) {
+    uint64_t hi = rng_next(self);
+
+    return (hi << 32) | rng_next(self);
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#include <wetris/rollback.h>
+#include <wetris/clock.h>
+
+#include <string.h>
+
+_Static_assert(
+    (ROLLBACK_HISTORY & (ROLLBACK_HISTORY - 1)) == 0,
+    "the history must be a power of two"
+);
+_Static_assert(
+    ROLLBACK_MAX_FRAMES < ROLLBACK_HISTORY / 2,
+    "the history must hold the frames that can be rolled back"
+);
+
+static size_t slot(uint64_t frame) {
+    return (size_t)(frame & (ROLLBACK_HISTORY - 1));
+}
+
+static int remote_player(const struct Rollback *self) {
+    return (self->local + 1) % VERSUS_PLAYERS;
+}
+
+static void step(struct Rollback *self, uint64_t frame) {
+    uint8_t inputs[VERSUS_PLAYERS];
+
+    inputs[self->local] = self->local_inputs[slot(frame)];
+    /* Inputs are rare and mostly single presses, so an empty one is the best
+     * guess */
+    inputs[remote_player(self)] =
+        frame < self->remote_frames ? self->remote_inputs[slot(frame)] : 0;
+
+    versus_step(&self->versus, inputs);
+}
+
+void rollback_init(struct Rollback *self, uint64_t seed, int local) {
+    memset(self, 0, sizeof(*self));
+    versus_init(&self->versus, seed);
+    self->local = local;
+    self->mispredicted = UINT64_MAX;
+}
+
+void rollback_add_remote(
+    struct Rollback *self, uint64_t first, const uint8_t *inputs, int count
+) {
+    uint64_t present = self->versus.frame;
+
+    for (int i = 0; i < count; ++i) {
+        uint64_t frame = first + (uint64_t)i;
+
+        if (frame < self->remote_frames) {
+            continue;
+        }
+
+        /* A gap, or further ahead than the peer can be */
+        if (frame > self->remote_frames ||
+            frame >= present + ROLLBACK_HISTORY - ROLLBACK_MAX_FRAMES) {
+            break;
+        }
+
+        /* Frames in the past were simulated with an empty input */
+        if (frame < present && inputs[i] != 0 && frame < self->mispredicted) {
+            self->mispredicted = frame;
+        }
+
+        self->remote_inputs[slot(frame)] = inputs[i];
+        ++self->remote_frames;
+    }
+}
+
+void rollback_ack(struct Rollback *self, uint64_t frames) {
+    if (frames > self->acked && frames <= self->versus.frame) {
+        self->acked = frames;
+    }
+}
+
+void rollback_resimulate(struct Rollback *self) {
+    uint64_t present = self->versus.frame;
+    uint64_t start = self->mispredicted;
+
+    if (start >= present) {
+        return;
+    }
+
+    uint64_t start_time = clock_ns();
+
+    /* The snapshot of the first frame stays, it precedes the wrong input */
+    versus_restore(&self->versus, &self->snapshots[slot(start)]);
+
+    for (uint64_t frame = start; frame < present; ++frame) {
+        if (frame > start) {
+            versus_snapshot(&self->versus, &self->snapshots[slot(frame)]);
+        }
+
+        step(self, frame);
+    }
+
+    int depth = (int)(present - start);
+    uint64_t elapsed = clock_ns() - start_time;
+
+    ++self->rollbacks;
+    self->resimulated += (uint64_t)depth;
+    self->rollback_ns += elapsed;
+
+    if (depth > self->max_depth) {
+        self->max_depth = depth;
+    }
+
+    if (elapsed > self->max_rollback_ns) {
+        self->max_rollback_ns = elapsed;
+    }
+
+    self->mispredicted = UINT64_MAX;
+}
+
+bool rollback_advance(struct Rollback *self, uint8_t input) {
+    rollback_resimulate(self);
+
+    uint64_t frame = self->versus.frame;
+
+    /* Unacknowledged inputs must stay in the history to be sent again */
+    if (frame >= self->remote_frames + ROLLBACK_MAX_FRAMES ||
+        frame >= self->acked + ROLLBACK_HISTORY) {
+        ++self->stalls;
+
+        return false;
+    }
+
+    versus_snapshot(&self->versus, &self->snapshots[slot(frame)]);
+    self->local_inputs[slot(frame)] = input;
+    step(self, frame);
+
+    return true;
+}
+
+int rollback_unacked(
+    const struct Rollback *self, uint64_t *first, uint8_t *inputs, int max
+) {
+    uint64_t count = self->versus.frame - self->acked;
+
+    if (count > (uint64_t)max) {
+        count = (uint64_t)max;
+    }
+
+    *first = self->acked;
+
+    for (uint64_t i = 0; i < count; ++i) {
+        inputs[i] = self->local_inputs[slot(self->acked + i)];
+    }
+
+    return (int)count;
+}
@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+/*
+ * Steps a batch of games with random actions next to a plain tetrion per game,
+ * which is ticked until its piece falls once per step. The boards, pieces and
+ * rewards must stay the same, restarts after a game over included. Also
+ * prints how many game steps a second a large batch does.
+ */
+
+#include <wetris/env.h>
+#include <wetris/rng.h>
+#include <wetris/tetrion.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define GAMES 16
+#define STEPS 20000
+#define BENCH_GAMES 4096
+#define BENCH_STEPS 500
+#define SEED 1
+
+static const enum TetrionAction g_actions[] = {
+    [ENV_ACTION_MOVE_LEFT] = TETRION_ACTION_MOVE_LEFT,
+    [ENV_ACTION_MOVE_RIGHT] = TETRION_ACTION_MOVE_RIGHT,
+    [ENV_ACTION_ROTATE] = TETRION_ACTION_ROTATE,
+    [ENV_ACTION_ROTATE_CNT] = TETRION_ACTION_ROTATE_CNT,
+    [ENV_ACTION_HARD_DROP] = TETRION_ACTION_HARD_DROP,
+};
+
+static double now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* The tetrion has no action to fall by a single row, so no soft drops. */
+static uint8_t random_action(struct Rng *rng) {
+    static const enum EnvAction actions[] = {
+        ENV_ACTION_NONE,      ENV_ACTION_NONE,       ENV_ACTION_MOVE_LEFT,
+        ENV_ACTION_MOVE_LEFT, ENV_ACTION_MOVE_RIGHT, ENV_ACTION_MOVE_RIGHT,
+        ENV_ACTION_ROTATE,    ENV_ACTION_ROTATE_CNT, ENV_ACTION_HARD_DROP,
+    };
+    uint32_t count = (uint32_t)(sizeof(actions) / sizeof(actions[0]));
+
+    return (uint8_t)actions[rng_range(rng, count)];
+}
+
+static void drain_events(struct Tetrion *tetrion) {
+    enum TetrionEvent event;
+
+    while (tetrion_poll_event(tetrion, &event)) {
+    }
+}
+
+/*
+ * Applies the action and ticks until the piece falls or locks, like a step of
+ * the batch. Returns false if the game is over instead.
+ */
+static bool step_tetrion(struct Tetrion *tetrion, enum EnvAction action) {
+    enum TetrionEvent event;
+
+    if (action != ENV_ACTION_NONE) {
+        tetrion_apply(tetrion, g_actions[action]);
+    }
+
+    drain_events(tetrion);
+
+    for (;;) {
+        bool fell = false;
+
+        tetrion_tick(tetrion);
+
+        /* Every fall scores, even when the score doesn't change */
+        while (tetrion_poll_event(tetrion, &event)) {
+            fell |= event == TETRION_EVENT_SCORE_CHANGED;
+        }
+
+        if (tetrion->state == TETRION_STATE_GAME_OVER) {
+            return false;
+        }
+
+        if (fell) {
+            return true;
+        }
+    }
+}
+
+static bool same_game(
+    const struct EnvBatch *batch, int i, const struct Tetrion *tetrion
+) {
+    const struct Board *board = &batch->boards[i];
+    const struct Piece *piece = &batch->pieces[i];
+
+    return memcmp(board->rows, tetrion->board.rows, sizeof(board->rows)) == 0 &&
+           memcmp(
+               board->colors, tetrion->board.colors, sizeof(board->colors)
+           ) == 0 &&
+           piece->id == tetrion->piece.id &&
+           piece->rotation == tetrion->piece.rotation &&
+           piece->pos.x == tetrion->piece.pos.x &&
+           piece->pos.y == tetrion->piece.pos.y &&
+           batch->next_pieces[i].id == tetrion->preview[0].id;
+}
+
+static bool check(const struct TetrionConfig *config) {
+    struct EnvBatch batch;
+    struct Tetrion *tetrions = malloc(GAMES * sizeof(*tetrions));
+    uint8_t actions[GAMES];
+    int32_t rewards[GAMES];
+    bool done[GAMES];
+    struct Rng rng;
+    bool ok = true;
+    int games_over = 0;
+
+    if (!tetrions || !env_batch_init(&batch, GAMES, config)) {
+        fprintf(stderr, "out of memory\n");
+        free(tetrions);
+
+        return false;
+    }
+
+    /* The seeds of the games, as the batch derives them */
+    rng_seed(&rng, config->seed);
+
+    for (int i = 0; i < GAMES; ++i) {
+        struct TetrionConfig game_config = *config;
+
+        game_config.seed = rng_next64(&rng);
+        game_config.clear_delay = 0;
+        game_config.preview = 1;
+        tetrion_init(&tetrions[i], &game_config);
+        tetrion_apply(&tetrions[i], TETRION_ACTION_START);
+    }
+
+    for (int step = 0; step < STEPS && ok; ++step) {
+        for (int i = 0; i < GAMES; ++i) {
+            actions[i] = random_action(&rng);
+        }
+
+        env_batch_step(&batch, actions, rewards, done);
+
+        for (int i = 0; i < GAMES && ok; ++i) {
+            struct Tetrion *tetrion = &tetrions[i];
+            int32_t score = tetrion->score;
+            bool playing = step_tetrion(tetrion, (enum EnvAction)actions[i]);
+
+            ok = playing && tetrion->score - score == rewards[i];
+
+            /* The tetrion notices that the next piece doesn't fit a fall
+             * later, then restarts seeded like the game of the batch */
+            if (ok && done[i]) {
+                ok = !step_tetrion(tetrion, ENV_ACTION_NONE);
+                tetrion_apply(tetrion, TETRION_ACTION_START);
+                ++games_over;
+            }
+
+            ok = ok && same_game(&batch, i, tetrion);
+
+            if (!ok) {
+                fprintf(
+                    stderr, "game %d differs from its tetrion at step %d\n", i,
+                    step
+                );
+            }
+        }
+    }
+
+    env_batch_deinit(&batch);
+    free(tetrions);
+
+    if (ok) {
+        printf(
+            "%d games stepped %d times like tetrions, %d games over\n", GAMES,
+            STEPS, games_over
+        );
+    }
+
+    return ok;
+}
+
+static bool bench(const struct TetrionConfig *config) {
+    struct EnvBatch batch;
+    uint8_t *actions = malloc(BENCH_GAMES);
+    int32_t *rewards = malloc(BENCH_GAMES * sizeof(*rewards));
+    bool *done = malloc(BENCH_GAMES * sizeof(*done));
+    struct Rng rng;
+
+    if (!actions || !rewards || !done ||
+        !env_batch_init(&batch, BENCH_GAMES, config)) {
+        fprintf(stderr, "out of memory\n");
+        free(actions);
+        free(rewards);
+        free(done);
+
+        return false;
+    }
+
+    rng_seed(&rng, config->seed);
+
+    double elapsed = 0.0;
+
+    for (int step = 0; step < BENCH_STEPS; ++step) {
+        for (int i = 0; i < BENCH_GAMES; ++i) {
+            actions[i] = random_action(&rng);
+        }
+
+        double start_time = now();
+
+        env_batch_step(&batch, actions, rewards, done);
+        elapsed += now() - start_time;
+    }
+
+    printf(
+        "%.1f million game steps a second\n",
+        (double)BENCH_GAMES * BENCH_STEPS / elapsed / 1e6
+    );
+
+    env_batch_deinit(&batch);
+    free(actions);
+    free(rewards);
+    free(done);
+
+    return true;
+}
+
+int main(void) {
+    struct TetrionConfig config = tetrion_config_default();
+
+    config.seed = SEED;
+    config.randomizer = RANDOMIZER_BAG;
+    /* Not the defaults, so the scoring of the configuration must be used */
+    config.scoring.row_deleted = 7;
+    config.scoring.landed = 3;
+    config.scoring.move = 2;
+
+    return check(&config) && bench(&config) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+/*
+ * Checks the board features computed by the kernel compiled into features.c
+ * against a plain computation cell by cell, on random boards. It's built once
+ * per kernel with the flags selecting it, the name of the kernel expected is
+ * given as the argument.
+ */
+
+#include <wetris/features.h>
+#include <wetris/rng.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BOARDS 200000
+#define BATCH 64
+#define SEED 1
+/* Tells ctest that the CPU can't run the kernel */
+#define EXIT_SKIP 77
+
+static bool occupied(const struct Board *board, int x, int y) {
+    return (board->rows[y] >> x) & 1u;
+}
+
+static void compute(const struct Board *board, struct BoardFeatures *features) {
+    memset(features, 0, sizeof(*features));
+
+    for (int x = 1; x < BOARD_WIDTH - 1; ++x) {
+        int height = 0;
+        int run = 0;
+
+        for (int y = 0; y < BOARD_HEIGHT - 1; ++y) {
+            bool cell = occupied(board, x, y);
+
+            if (cell && height == 0) {
+                height = BOARD_HEIGHT - 1 - y;
+            } else if (!cell && height > 0) {
+                ++features->holes;
+            }
+
+            /* The top edge counts as empty, the floor as occupied */
+            if (cell != (y > 0 && occupied(board, x, y - 1))) {
+                ++features->column_transitions;
+            }
+
+            if (!cell && occupied(board, x - 1, y) &&
+                occupied(board, x + 1, y)) {
+                features->wells += ++run;
+            } else {
+                run = 0;
+            }
+        }
+
+        if (!occupied(board, x, BOARD_HEIGHT - 2)) {
+            ++features->column_transitions;
+        }
+
+        features->heights[x - 1] = (uint8_t)height;
+        features->aggregate_height += height;
+
+        if (height > features->max_height) {
+            features->max_height = height;
+        }
+
+        if (x > 1) {
+            features->bumpiness += abs(height - features->heights[x - 2]);
+        }
+    }
+
+    for (int y = 0; y < BOARD_HEIGHT - 1; ++y) {
+        for (int x = 0; x < BOARD_WIDTH - 1; ++x) {
+            if (occupied(board, x, y) != occupied(board, x + 1, y)) {
+                ++features->row_transitions;
+            }
+        }
+    }
+}
+
+static bool same_features(
+    const struct BoardFeatures *a, const struct BoardFeatures *b
+) {
+    return memcmp(a->heights, b->heights, sizeof(a->heights)) == 0 &&
+           a->max_height == b->max_height &&
+           a->aggregate_height == b->aggregate_height &&
+           a->bumpiness == b->bumpiness && a->holes == b->holes &&
+           a->row_transitions == b->row_transitions &&
+           a->column_transitions == b->column_transitions &&
+           a->wells == b->wells;
+}
+
+/* Empty above a random row, below it every cell is filled at a random rate. */
+static void random_board(struct Rng *rng, struct Board *board) {
+    int top = (int)rng_range(rng, BOARD_HEIGHT);
+    uint32_t density = rng_range(rng, 101);
+
+    board_clear(board);
+
+    for (int y = top; y < BOARD_HEIGHT - 1; ++y) {
+        for (int x = 1; x < BOARD_WIDTH - 1; ++x) {
+            if (rng_range(rng, 100) < density) {
+                board->rows[y] |= (uint16_t)(1u << x);
+            }
+        }
+    }
+
+    board_update_heights(board);
+    board_update_hash(board);
+}
+
+static bool cpu_supports(const char *kernel) {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    if (strcmp(kernel, "avx2") == 0) {
+        return __builtin_cpu_supports("avx2");
+    }
+#else
+    (void)kernel;
+#endif
+
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s scalar|sse2|avx2\n", argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    if (strcmp(argv[1], features_kernel()) != 0) {
+        fprintf(
+            stderr, "the %s kernel was compiled instead of %s\n",
+            features_kernel(), argv[1]
+        );
+
+        return EXIT_FAILURE;
+    }
+
+    if (!cpu_supports(argv[1])) {
+        printf("the CPU doesn't support %s\n", argv[1]);
+
+        return EXIT_SKIP;
+    }
+
+    struct Board boards[BATCH];
+    struct BoardFeatures features[BATCH];
+    struct Rng rng;
+
+    rng_seed(&rng, SEED);
+
+    for (int checked = 0; checked < BOARDS; checked += BATCH) {
+        for (int i = 0; i < BATCH; ++i) {
+            random_board(&rng, &boards[i]);
+        }
+
+        features_compute_batch(boards, BATCH, features);
+
+        for (int i = 0; i < BATCH; ++i) {
+            struct BoardFeatures expected;
+
+            compute(&boards[i], &expected);
+
+            if (!same_features(&features[i], &expected)) {
+                fprintf(
+                    stderr, "the %s kernel is wrong on board %d\n", argv[1],
+                    checked + i
+                );
+
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    printf("the %s kernel agrees on %d boards\n", argv[1], BOARDS);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+/*
+ * Records a game with random actions and restarts, saves and loads it, then
+ * seeks to ticks forwards, backwards and in random order. After every seek the
+ * game must be the same as when played straight from the start to that tick,
+ * whether a keyframe was restored or not.
+ */
+
+#include <wetris/replay.h>
+#include <wetris/rng.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PATH "wetris_test_replay.wtrp"
+#define DURATION 60 /* s */
+#define TARGETS 64
+#define SEED 1
+
+static void snapshot(
+    const struct Tetrion *tetrion, struct TetrionSnapshot *snapshot
+) {
+    /* No garbage in the padding, equal games give equal snapshots */
+    memset(snapshot, 0, sizeof(*snapshot));
+    tetrion_snapshot(tetrion, snapshot);
+}
+
+static bool same_game(
+    const struct Tetrion *tetrion, const struct TetrionSnapshot *expected
+) {
+    struct TetrionSnapshot actual;
+
+    snapshot(tetrion, &actual);
+
+    return memcmp(&actual, expected, sizeof(actual)) == 0;
+}
+
+/* A few actions a second and a restart after every game over. */
+static void record(
+    struct Replay *replay, struct Tetrion *tetrion, struct Rng *rng
+) {
+    uint64_t duration = (uint64_t)DURATION * tetrion->config.tick_rate;
+
+    while (tetrion->time < duration) {
+        enum TetrionAction action = TOTAL_TETRION_ACTIONS;
+
+        if (tetrion->state != TETRION_STATE_NORMAL) {
+            action = TETRION_ACTION_START;
+        } else if (rng_range(rng, 100) == 0) {
+            action = (enum TetrionAction)rng_range(rng, TOTAL_TETRION_ACTIONS);
+        }
+
+        if (action != TOTAL_TETRION_ACTIONS) {
+            replay_record(replay, tetrion->time, action);
+            tetrion_apply(tetrion, action);
+        }
+
+        tetrion_tick(tetrion);
+    }
+
+    replay_finish(replay, tetrion->time);
+}
+
+static int compare_times(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/* Seeks to the targets in the given order, expected[i] belongs to times[i]. */
+static bool seek(
+    const struct Replay *replay, const uint64_t *times,
+    const struct TetrionSnapshot *expected, const int *order, const char *name
+) {
+    struct Tetrion tetrion;
+    struct ReplayPlayer player;
+
+    tetrion_init(&tetrion, &replay->config);
+    replay_player_init(&player, replay);
+
+    for (int i = 0; i < TARGETS; ++i) {
+        int target = order[i];
+
+        replay_player_seek(&player, &tetrion, times[target]);
+
+        if (tetrion.time != times[target] ||
+            !same_game(&tetrion, &expected[target])) {
+            fprintf(
+                stderr, "seeking %s: tick %llu differs\n", name,
+                (unsigned long long)times[target]
+            );
+
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(void) {
+    struct TetrionConfig config = tetrion_config_default();
+    struct Replay recording;
+    struct Tetrion tetrion;
+    struct Rng rng;
+
+    config.seed = SEED;
+    config.preview = 3;
+    rng_seed(&rng, SEED);
+    replay_init(&recording, &config);
+    tetrion_init(&tetrion, &config);
+    record(&recording, &tetrion, &rng);
+
+    struct TetrionSnapshot last;
+    struct Replay replay;
+
+    snapshot(&tetrion, &last);
+
+    if (!replay_save(&recording, PATH) || !replay_load(&replay, PATH)) {
+        fprintf(stderr, "cannot save and load the replay\n");
+
+        return EXIT_FAILURE;
+    }
+
+    replay_deinit(&recording);
+
+    if (replay.keyframe_count == 0) {
+        fprintf(stderr, "the replay has no keyframes\n");
+
+        return EXIT_FAILURE;
+    }
+
+    /* The ticks to seek to, with the ends included */
+    uint64_t times[TARGETS];
+    struct TetrionSnapshot expected[TARGETS];
+    int order[TARGETS];
+
+    times[0] = 0;
+    times[1] = replay.duration;
+
+    for (int i = 2; i < TARGETS; ++i) {
+        times[i] = rng_next64(&rng) % (replay.duration + 1);
+    }
+
+    qsort(times, TARGETS, sizeof(times[0]), compare_times);
+
+    /* Played straight from the start */
+    struct ReplayPlayer player;
+
+    tetrion_init(&tetrion, &replay.config);
+    replay_player_init(&player, &replay);
+
+    for (int i = 0; i < TARGETS; ++i) {
+        replay_player_advance(&player, &tetrion, times[i]);
+        snapshot(&tetrion, &expected[i]);
+    }
+
+    bool ok = same_game(&tetrion, &last);
+
+    if (!ok) {
+        fprintf(stderr, "the loaded replay doesn't reproduce the game\n");
+    }
+
+    for (int i = 0; i < TARGETS; ++i) {
+        order[i] = i;
+    }
+
+    ok = ok && seek(&replay, times, expected, order, "forwards");
+
+    for (int i = 0; i < TARGETS; ++i) {
+        order[i] = TARGETS - 1 - i;
+    }
+
+    ok = ok && seek(&replay, times, expected, order, "backwards");
+
+    for (int i = TARGETS - 1; i > 0; --i) {
+        int j = (int)rng_range(&rng, (uint32_t)i + 1);
+        int swapped = order[i];
+
+        order[i] = order[j];
+        order[j] = swapped;
+    }
+
+    ok = ok && seek(&replay, times, expected, order, "in random order");
+
+    if (ok) {
+        printf(
+            "%d seeks in %llu ticks with %u keyframes\n", 3 * TARGETS,
+            (unsigned long long)replay.duration, replay.keyframe_count
+        );
+    }
+
+    replay_deinit(&replay);
+    remove(PATH);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+/*
+ * Checks that the board of libwetris follows restores of snapshots whose locked
+ * blocks differ only in their colors (piece kinds), which it caches.
+ */
+
+#include <wetris/tetrion.h>
+#include <wetris/wetris.h>
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* In front of the tetrion snapshot, see wetris.c */
+#define SNAPSHOT_HEADER_SIZE 8
+#define MAX_STEPS 100000
+
+static bool has_locked_block(const uint8_t *board) {
+    for (int i = 0; i < WETRIS_BOARD_SIZE; ++i) {
+        if (board[i] != 0 && !(board[i] & WETRIS_CELL_FALLING)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* The kind of the locked block stored in a snapshot at the cell. */
+static uint8_t stored_kind(const uint8_t *buffer, int cell) {
+    struct TetrionSnapshot snapshot;
+    int shift = BOARD_COLOR_BITS * (cell % WETRIS_BOARD_WIDTH);
+
+    memcpy(&snapshot, &buffer[SNAPSHOT_HEADER_SIZE], sizeof(snapshot));
+
+    return (uint8_t)((snapshot.colors[cell / WETRIS_BOARD_WIDTH] >> shift) &
+                     BOARD_COLOR_MASK);
+}
+
+int main(void) {
+    struct Wetris *wetris = wetris_create(1);
+    uint8_t first[WETRIS_SNAPSHOT_SIZE];
+    uint8_t second[WETRIS_SNAPSHOT_SIZE];
+    struct TetrionSnapshot snapshot;
+
+    if (!wetris) {
+        fprintf(stderr, "out of memory\n");
+
+        return EXIT_FAILURE;
+    }
+
+    /* A drop restarts the fall timer, the piece locks when it runs out */
+    wetris_step(wetris, WETRIS_ACTION_HARD_DROP);
+
+    for (int i = 0; i < MAX_STEPS && !has_locked_block(wetris_board(wetris));
+         ++i) {
+        wetris_step(wetris, WETRIS_ACTION_NONE);
+    }
+
+    if (!wetris_snapshot(wetris, first, sizeof(first))) {
+        fprintf(stderr, "cannot take a snapshot\n");
+
+        return EXIT_FAILURE;
+    }
+
+    /* The same snapshot with one locked block of another kind */
+    memcpy(&snapshot, &first[SNAPSHOT_HEADER_SIZE], sizeof(snapshot));
+
+    int cell = -1;
+
+    for (int y = 0; y < WETRIS_BOARD_HEIGHT && cell < 0; ++y) {
+        for (int x = 0; x < WETRIS_BOARD_WIDTH; ++x) {
+            if (!(snapshot.rows[y] & (1u << (x + 1)))) {
+                continue;
+            }
+
+            int shift = BOARD_COLOR_BITS * x;
+            uint32_t color = (snapshot.colors[y] >> shift) & BOARD_COLOR_MASK;
+            uint32_t other = color % TOTAL_PIECES + 1;
+
+            snapshot.colors[y] &= ~(BOARD_COLOR_MASK << shift);
+            snapshot.colors[y] |= other << shift;
+            cell = y * WETRIS_BOARD_WIDTH + x;
+
+            break;
+        }
+    }
+
+    if (cell < 0) {
+        fprintf(stderr, "no block was locked\n");
+
+        return EXIT_FAILURE;
+    }
+
+    memcpy(second, first, sizeof(second));
+    memcpy(&second[SNAPSHOT_HEADER_SIZE], &snapshot, sizeof(snapshot));
+
+    bool ok = true;
+
+    for (int round = 0; round < 2; ++round) {
+        const uint8_t *buffers[] = {first, second};
+
+        for (int i = 0; i < 2; ++i) {
+            if (!wetris_restore(wetris, buffers[i], WETRIS_SNAPSHOT_SIZE)) {
+                fprintf(stderr, "cannot restore snapshot %d\n", i);
+
+                return EXIT_FAILURE;
+            }
+
+            uint8_t shown = wetris_board(wetris)[cell];
+            uint8_t expected = stored_kind(buffers[i], cell);
+
+            if (shown != expected) {
+                fprintf(
+                    stderr, "snapshot %d: the cell shows %d instead of %d\n", i,
+                    shown, expected
+                );
+                ok = false;
+            }
+        }
+    }
+
+    wetris_destroy(wetris);
+    printf(ok ? "ok\n" : "stale board\n");
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -4,96 +4,66 @@
  * This file is licensed under the MIT License (see LICENSE.md).
  */
 
-#include <stdio.h>
 #include <wetris/tetrion.h>
 
 #include <wetris/direction.h>
-#include <wetris/tileset.h>
-#include <wetris/utils.h>
 
-#include <stdlib.h>
+#include <assert.h>
+#include <string.h>
 
-static enum TileId **new_tilemap(int w, int h) {
-    enum TileId **tilemap = mem_alloc((size_t)h * sizeof(enum TileId *));
+#define SNAPSHOT_DROPPED 0x1u
+#define SNAPSHOT_LOCK_SAVED_FALL_INTERVAL 0x2u
 
-    if (!tilemap) {
-        return NULL;
-    }
+_Static_assert(
+    sizeof(struct TetrionSnapshot) <= 200, "snapshots are meant to be small"
+);
 
-    tilemap[0] = mem_alloc((size_t)(w * h) * sizeof(enum TileId));
+static uint32_t saturate_u32(uint64_t value) {
+    return value > UINT32_MAX ? UINT32_MAX : (uint32_t)value;
+}
 
-    if (!tilemap[0]) {
-        mem_free(tilemap);
+static uint64_t ms_to_ticks(const struct Tetrion *self, uint64_t ms) {
+    return ms * self->config.tick_rate / 1000;
+}
 
-        return NULL;
-    }
+/* Shortens the interval by the given number of ms within the fall limits. */
+static uint64_t shorten_interval(
+    const struct Tetrion *self, uint64_t interval, uint64_t ms
+) {
+    uint64_t min = ms_to_ticks(self, MIN_FALL_INTERVAL);
+    uint64_t max = ms_to_ticks(self, MAX_FALL_INTERVAL);
+    uint64_t delta = ms_to_ticks(self, ms);
 
-    for (int i = 1; i < h; ++i) {
-        tilemap[i] = tilemap[0] + i * w;
-    }
+    interval = interval > delta ? interval - delta : 0;
 
-    for (int y = 0; y < h; ++y) {
-        for (int x = 0; x < w; ++x) {
-            tilemap[y][x] = TILE_NULL;
-        }
+    if (interval < min) {
+        return min;
+    } else if (interval > max) {
+        return max;
     }
 
-    return tilemap;
+    return interval;
 }
 
-static void place_tiles(struct Tetrion *self) {
-    int w = (int)self->rect.w;
-    int h = (int)self->rect.h;
-
-    for (int y = 0; y < h; ++y) {
-        for (int x = 0; x < w; ++x) {
-            self->tilemap[y][x] = TILE_BACKGROUND;
-        }
-    }
+static void push_event(struct Tetrion *self, enum TetrionEvent event) {
+    uint32_t bit = 1u << event;
 
-    /* Right and left walls */
-    for (int y = 0; y < h; ++y) {
-        self->tilemap[y][0] = TILE_WALL;
-        self->tilemap[y][w - 1] = TILE_WALL;
+    if (self->pending_events & bit) {
+        return;
     }
 
-    /* Bottom */
-    for (int x = 0; x < w; ++x) {
-        self->tilemap[h - 1][x] = TILE_WALL;
-    }
+    self->pending_events |= bit;
+    self->events[self->event_count++] = event;
 }
 
 static bool piece_fits(struct Tetrion *self) {
-    for (int y = 0; y < PIECE_HEIGHT; ++y) {
-        int tile_y = self->piece.pos.y + y;
-
-        for (int x = 0; x < PIECE_WIDTH; ++x) {
-            if (!self->piece.tiles[y][x]) {
-                continue;
-            }
-
-            int tile_x = self->piece.pos.x + x;
-
-            if (tile_x < 0 || tile_x >= self->rect.w || tile_y < 0 ||
-                tile_y >= self->rect.h) {
-                return false;
-            }
-
-            enum TileId tile = self->tilemap[tile_y][tile_x];
-
-            if (!tile_is_passable(tile)) {
-                return false;
-            }
-        }
-    }
-
-    return true;
+    return board_piece_fits(&self->board, &self->piece);
 }
 
 static bool move_piece(struct Tetrion *self, enum Direction dir) {
-    SDL_assert(dir >= DIR_DOWN && dir <= DIR_LEFT);
+    assert(dir >= DIR_DOWN && dir <= DIR_LEFT);
 
-    struct SDL_Point old_pos = self->piece.pos;
+    struct Point old_pos = self->piece.pos;
 
     switch (dir) {
     case DIR_DOWN:
@@ -116,45 +86,14 @@ static bool move_piece(struct Tetrion *self, enum Direction dir) {
         return false;
     }
 
-    sfx_store_play(self->sfx_store, SFX_MOVE);
+    push_event(self, TETRION_EVENT_MOVED);
 
     return true;
 }
 
-static bool try_adjust_piece(struct Tetrion *self) {
-    for (int i = 0; i < 5; ++i) {
-        struct SDL_Point kick_off = self->piece.kick_offs[i];
-
-        self->piece.pos.x += kick_off.x;
-        self->piece.pos.y += kick_off.y;
-
-        if (piece_fits(self)) {
-            return true;
-        }
-    }
-
-    return false;
-}
-
-static void rotate_piece_90(struct Tetrion *self) {
-    struct Piece old_piece = self->piece;
-    piece_rotate_90(&self->piece);
-
-    if (!piece_fits(self) && !try_adjust_piece(self)) {
-        self->piece = old_piece;
-    } else {
-        sfx_store_play(self->sfx_store, SFX_ROTATE);
-    }
-}
-
-static void rotate_piece_90_cnt(struct Tetrion *self) {
-    struct Piece old_piece = self->piece;
-    piece_rotate_90_cnt(&self->piece);
-
-    if (!piece_fits(self) && !try_adjust_piece(self)) {
-        self->piece = old_piece;
-    } else {
-        sfx_store_play(self->sfx_store, SFX_ROTATE);
+static void rotate_piece(struct Tetrion *self, int rotation) {
+    if (board_rotate_piece(&self->board, &self->piece, rotation)) {
+        push_event(self, TETRION_EVENT_ROTATED);
     }
 }
 
@@ -162,57 +101,38 @@ static void speed_up_fall(struct Tetrion *self) {
     self->saved_fall_interval = self->ticker.interval;
     self->lock_saved_fall_interval = true;
     self->ticker.interval /= SPEED_UP_RATE;
-    timer_restart(&self->ticker);
+    timer_restart(&self->ticker, self->time);
 }
 
 static void slow_down_fall(struct Tetrion *self) {
     self->ticker.interval = self->saved_fall_interval;
     self->lock_saved_fall_interval = false;
-    timer_restart(&self->ticker);
+    timer_restart(&self->ticker, self->time);
 }
 
 static struct Piece gen_piece(struct Tetrion *self) {
-    enum PieceId id = (enum PieceId)SDL_rand(TOTAL_PIECES);
-
-    struct Piece piece = piece_new(id);
-    piece.pos.x = self->rect.x + PIECE_WIDTH / 2;
-
-    return piece;
+    return board_spawn_piece(randomizer_next(&self->randomizer));
 }
 
-static void put_piece(struct Tetrion *self) {
-    for (int y = 0; y < PIECE_HEIGHT; ++y) {
-        int tile_y = self->piece.pos.y + y;
+/* Takes the first piece of the preview and refills it from the randomizer. */
+static struct Piece next_piece(struct Tetrion *self) {
+    struct Piece piece = self->preview[0];
 
-        if (tile_y < 0 || tile_y >= self->rect.h) {
-            return;
-        }
-
-        for (int x = 0; x < PIECE_WIDTH; ++x) {
-            int tile_x = self->piece.pos.x + x;
-
-            if (tile_x < 0 || tile_x >= self->rect.w) {
-                continue;
-            }
-
-            if (self->piece.tiles[y][x]) {
-                self->tilemap[tile_y][tile_x] = self->piece.tile;
-            }
-        }
+    for (int i = 1; i < self->config.preview; ++i) {
+        self->preview[i - 1] = self->preview[i];
     }
-}
 
-static void delete_row(struct Tetrion *self, int i) {
-    SDL_assert(i >= 0);
+    self->preview[self->config.preview - 1] = gen_piece(self);
 
-    for (int y = i; y > 0; --y) {
-        for (int x = 1; x < self->rect.w - 1; ++x) {
-            self->tilemap[y][x] = self->tilemap[y - 1][x];
-            self->tilemap[y - 1][x] = TILE_BACKGROUND;
-        }
-    }
+    return piece;
+}
 
-    sfx_store_play(self->sfx_store, SFX_DELETED_ROW);
+static void put_piece(struct Tetrion *self) {
+    board_put(
+        &self->board, piece_mask(&self->piece), self->piece.pos.x,
+        self->piece.pos.y, piece_tile(self->piece.id)
+    );
+    ++self->generation;
 }
 
 static void add_score(struct Tetrion *self, int score) {
@@ -222,76 +142,75 @@ static void add_score(struct Tetrion *self, int score) {
     if (self->score > 0 && new_score_ratio >= next_score_ratio) {
         ++self->level;
 
-        sfx_store_play(self->sfx_store, SFX_LEVEL_UP);
+        push_event(self, TETRION_EVENT_LEVEL_UP);
 
         if (self->lock_saved_fall_interval) {
-            self->ticker.interval -= SCORE_SPEED_RATE / SPEED_UP_RATE;
-            self->ticker.interval = SDL_clamp(
-                self->ticker.interval, MIN_FALL_INTERVAL, MAX_FALL_INTERVAL
+            self->ticker.interval = shorten_interval(
+                self, self->ticker.interval, SCORE_SPEED_RATE / SPEED_UP_RATE
             );
-
-            self->saved_fall_interval -= SCORE_SPEED_RATE;
-            self->saved_fall_interval = SDL_clamp(
-                self->saved_fall_interval, MIN_FALL_INTERVAL, MAX_FALL_INTERVAL
+            self->saved_fall_interval = shorten_interval(
+                self, self->saved_fall_interval, SCORE_SPEED_RATE
             );
         } else {
-            self->ticker.interval -= SCORE_SPEED_RATE;
-            self->ticker.interval = SDL_clamp(
-                self->ticker.interval, MIN_FALL_INTERVAL, MAX_FALL_INTERVAL
-            );
-
+            self->ticker.interval =
+                shorten_interval(self, self->ticker.interval, SCORE_SPEED_RATE);
             self->saved_fall_interval = self->ticker.interval;
         }
     }
 
     self->score += score;
-    ui_set_stats(self->ui, self->score, self->level);
+    push_event(self, TETRION_EVENT_SCORE_CHANGED);
 }
 
 static void drop_piece(struct Tetrion *self) {
-    for (int i = 0; i < self->rect.h - 1; ++i) {
-        if (!move_piece(self, DIR_DOWN)) {
-            self->dropped = true;
-            timer_restart(&self->ticker);
+    int distance = board_drop_distance(&self->board, &self->piece);
 
-            break;
-        }
+    if (distance > 0) {
+        self->piece.pos.y += distance;
 
-        add_score(self, SCORE_MOVE);
+        push_event(self, TETRION_EVENT_MOVED);
+        add_score(self, self->config.scoring.move * distance);
     }
+
+    self->dropped = true;
+    timer_restart(&self->ticker, self->time);
 }
 
 static void update_rows(struct Tetrion *self) {
-    for (int y = 0; y < self->rect.h - 1; ++y) { /* -1 for bottom walls */
-        int block_cnt = 0;
+    int cleared = board_clear_rows(&self->board);
 
-        for (int x = 1; x < self->rect.w - 1; ++x) { /* -1 for right wall */
-            enum TileId tile = self->tilemap[y][x];
+    if (cleared > 0) {
+        self->lines += cleared;
+        ++self->generation;
 
-            if (tile_is_block(tile)) {
-                ++block_cnt;
-            }
-        }
+        push_event(self, TETRION_EVENT_ROW_DELETED);
+        add_score(self, self->config.scoring.row_deleted * cleared);
+    }
 
-        if (block_cnt >= self->rect.w - 2) { /* -2 for walls */
-            delete_row(self, y);
-            add_score(self, SCORE_ROW_DELETED);
-            timer_restart(&self->ticker);
+    self->state = TETRION_STATE_NORMAL;
+    timer_restart(&self->ticker, self->time);
+}
 
-            return;
-        }
+static void handle_full_rows(struct Tetrion *self) {
+    if (board_full_rows(&self->board) == 0) {
+        return;
     }
 
-    self->state = TETRION_STATE_NORMAL;
+    if (self->config.clear_delay == 0) {
+        update_rows(self);
+    } else {
+        self->state = TETRION_STATE_UPDATING_ROWS;
+        self->clear_timer = timer_new(
+            ms_to_ticks(self, self->config.clear_delay), self->time
+        );
+    }
 }
 
 static void do_tick(struct Tetrion *self) {
     if (!piece_fits(self)) {
         self->state = TETRION_STATE_GAME_OVER;
 
-        ui_show_text(self->ui, TEXT_GAME_OVER);
-        ui_show_text(self->ui, TEXT_RETRY_OR_QUIT);
-        sfx_store_play(self->sfx_store, SFX_GAME_OVER);
+        push_event(self, TETRION_EVENT_GAME_OVER);
 
         return;
     }
@@ -299,115 +218,113 @@ static void do_tick(struct Tetrion *self) {
     if (!move_piece(self, DIR_DOWN)) {
         put_piece(self);
 
-        self->state = TETRION_STATE_UPDATING_ROWS;
+        self->piece = next_piece(self);
 
-        self->piece = self->next_piece;
-        self->next_piece = gen_piece(self);
-
-        ui_set_next_piece(self->ui, &self->next_piece);
+        push_event(self, TETRION_EVENT_NEXT_PIECE);
 
         if (self->dropped) {
             self->dropped = false;
-            sfx_store_play(self->sfx_store, SFX_DROP);
+            push_event(self, TETRION_EVENT_DROPPED);
         } else {
-            sfx_store_play(self->sfx_store, SFX_LANDED);
+            push_event(self, TETRION_EVENT_LANDED);
         }
 
-        add_score(self, SCORE_LANDED);
+        add_score(self, self->config.scoring.landed);
+        handle_full_rows(self);
     } else {
-        add_score(self, SCORE_MOVE);
+        add_score(self, self->config.scoring.move);
     }
 
-    timer_restart(&self->ticker);
+    timer_restart(&self->ticker, self->time);
 }
 
-static void render_piece_shadow(
-    struct Tetrion *self, struct SDL_Renderer *renderer, struct TileSet *tileset
-) {
-    for (int y = 0; y < PIECE_HEIGHT; ++y) {
-        int tile_y = self->piece.pos.y + y;
-
-        for (int x = 0; x < PIECE_WIDTH; ++x) {
-            int tile_x = self->piece.pos.x + x;
-
-            if (!self->piece.tiles[y][x]) {
-                continue;
-            }
-
-            for (int i = tile_y + 1; i < self->rect.h - 1 &&
-                                     tile_is_passable(self->tilemap[i][tile_x]);
-                 ++i) {
-                tileset_render_tile(
-                    tileset, renderer, TILE_FINAL_POS,
-                    TILE_WIDTH * (self->rect.x + tile_x),
-                    TILE_HEIGHT * (self->rect.y + i)
-                );
-            }
-        }
+static void start(struct Tetrion *self) {
+    if (self->state == TETRION_STATE_GAME_OVER) {
+        /* The next game is seeded from the current one, so a whole session
+         * can be reproduced from the initial seed. */
+        tetrion_reset(self, rng_next64(&self->randomizer.rng));
+        self->state = TETRION_STATE_NORMAL;
+
+        push_event(self, TETRION_EVENT_RESTARTED);
+    } else if (self->state == TETRION_STATE_NOT_STARTED) {
+        self->state = TETRION_STATE_NORMAL;
+
+        push_event(self, TETRION_EVENT_STARTED);
     }
 }
 
-bool tetrion_init(
-    struct Tetrion *self, struct SfxStore *sfx_store, struct UiState *ui, int x,
-    int y, int w, int h
-) {
-    self->tilemap = new_tilemap((int)w, (int)h);
+struct TetrionScoring tetrion_scoring_default(void) {
+    struct TetrionScoring scoring = {
+        .row_deleted = SCORE_ROW_DELETED,
+        .landed = SCORE_LANDED,
+        .move = SCORE_MOVE,
+    };
 
-    if (!self->tilemap) {
-        log_error("cannot create a tile map");
+    return scoring;
+}
 
-        return false;
-    }
+struct TetrionConfig tetrion_config_default(void) {
+    struct TetrionConfig config = {
+        .seed = 0,
+        .randomizer = RANDOMIZER_RANDOM,
+        .clear_delay = DEFAULT_CLEAR_DELAY,
+        .tick_rate = DEFAULT_TICK_RATE,
+        .preview = DEFAULT_PREVIEW,
+        .scoring = tetrion_scoring_default(),
+    };
 
-    self->rect.x = x / TILE_WIDTH;
-    self->rect.y = y / TILE_WIDTH;
-    self->rect.w = w;
-    self->rect.h = h;
-    self->sfx_store = sfx_store;
-    self->ui = ui;
+    return config;
+}
 
-    place_tiles(self);
-    tetrion_reset(self);
+void tetrion_init(struct Tetrion *self, const struct TetrionConfig *config) {
+    assert(config->tick_rate > 0);
+    assert(config->preview >= 1 && config->preview <= TETRION_MAX_PREVIEW);
 
-    return true;
+    self->config = *config;
+    self->generation = 0;
+    self->time = 0;
+    self->event_count = 0;
+    self->event_head = 0;
+    self->pending_events = 0;
+
+    tetrion_reset(self, config->seed);
 }
 
-void tetrion_reset(struct Tetrion *self) {
+void tetrion_reset(struct Tetrion *self, uint64_t seed) {
+    self->seed = seed;
+    randomizer_init(&self->randomizer, self->config.randomizer, seed);
+
     self->score = 0;
+    self->lines = 0;
     self->piece = gen_piece(self);
-    self->next_piece = gen_piece(self);
-    self->saved_fall_interval = DEFAULT_FALL_INTERVAL;
+
+    for (int i = 0; i < self->config.preview; ++i) {
+        self->preview[i] = gen_piece(self);
+    }
+    self->saved_fall_interval = ms_to_ticks(self, DEFAULT_FALL_INTERVAL);
     self->lock_saved_fall_interval = false;
-    self->ticker = timer_new(DEFAULT_FALL_INTERVAL);
+    self->ticker = timer_new(self->saved_fall_interval, self->time);
+    self->clear_timer =
+        timer_new(ms_to_ticks(self, self->config.clear_delay), self->time);
     self->state = TETRION_STATE_NOT_STARTED;
     self->dropped = false;
     self->level = 1;
 
-    for (int y = 0; y < self->rect.h - 1; ++y) {
-        for (int x = 1; x < self->rect.w - 1; ++x) {
-            self->tilemap[y][x] = TILE_BACKGROUND;
-        }
-    }
-}
-
-void tetrion_deinit(struct Tetrion *self) {
-    if (!self) {
-        return;
-    }
+    board_clear(&self->board);
+    ++self->generation;
 
-    if (self->tilemap) {
-        mem_free(self->tilemap[0]);
-        mem_free(self->tilemap);
-        self->tilemap = NULL;
-    }
+    push_event(self, TETRION_EVENT_SCORE_CHANGED);
+    push_event(self, TETRION_EVENT_NEXT_PIECE);
 }
 
-void tetrion_update(struct Tetrion *self) {
+void tetrion_tick(struct Tetrion *self) {
+    ++self->time;
+
     switch (self->state) {
     case TETRION_STATE_NOT_STARTED:
         break;
     case TETRION_STATE_NORMAL:
-        if (!timer_done(&self->ticker)) {
+        if (!timer_done(&self->ticker, self->time)) {
             break;
         }
 
@@ -415,7 +332,7 @@ void tetrion_update(struct Tetrion *self) {
 
         break;
     case TETRION_STATE_UPDATING_ROWS:
-        if (!timer_done(&self->ticker)) {
+        if (!timer_done(&self->clear_timer, self->time)) {
             break;
         }
 
@@ -427,85 +344,203 @@ void tetrion_update(struct Tetrion *self) {
     }
 }
 
-void tetrion_handle_input(struct Tetrion *self, struct InputState *state) {
-    if (self->state == TETRION_STATE_GAME_OVER) {
-        if (input_key_released(state, SDL_SCANCODE_SPACE)) {
-            tetrion_reset(self);
-            self->state = TETRION_STATE_NORMAL;
+void tetrion_apply(struct Tetrion *self, enum TetrionAction action) {
+    if (action == TETRION_ACTION_START) {
+        start(self);
 
-            ui_set_stats(self->ui, self->score, self->level);
-            ui_set_next_piece(self->ui, &self->next_piece);
+        return;
+    }
 
-            ui_hide_text(self->ui, TEXT_GAME_OVER);
-            ui_hide_text(self->ui, TEXT_RETRY_OR_QUIT);
-        }
-    } else if (self->state == TETRION_STATE_NOT_STARTED) {
-        if (input_key_released(state, SDL_SCANCODE_SPACE)) {
-            self->state = TETRION_STATE_NORMAL;
+    if (self->state != TETRION_STATE_NORMAL &&
+        self->state != TETRION_STATE_UPDATING_ROWS) {
+        return;
+    }
 
-            ui_hide_text(self->ui, TEXT_PRESS_SPACE);
-            sfx_store_play(self->sfx_store, SFX_LEVEL_UP);
-        }
+    switch (action) {
+    case TETRION_ACTION_START:
+        break;
+    case TETRION_ACTION_MOVE_LEFT:
+        move_piece(self, DIR_LEFT);
+
+        break;
+    case TETRION_ACTION_MOVE_RIGHT:
+        move_piece(self, DIR_RIGHT);
+
+        break;
+    case TETRION_ACTION_ROTATE:
+        rotate_piece(self, piece_rotation_cw(self->piece.rotation));
+
+        break;
+    case TETRION_ACTION_ROTATE_CNT:
+        rotate_piece(self, piece_rotation_cnt(self->piece.rotation));
+
+        break;
+    case TETRION_ACTION_SOFT_DROP_ON:
+        speed_up_fall(self);
+
+        break;
+    case TETRION_ACTION_SOFT_DROP_OFF:
+        slow_down_fall(self);
+
+        break;
+    case TETRION_ACTION_HARD_DROP:
+        drop_piece(self);
+
+        break;
+    case TOTAL_TETRION_ACTIONS:
+        break;
     }
+}
 
-    if (self->state == TETRION_STATE_NORMAL ||
-        self->state == TETRION_STATE_UPDATING_ROWS) {
-        if (input_key_down(state, SDL_SCANCODE_A) ||
-            input_key_down(state, SDL_SCANCODE_LEFT)) {
-            move_piece(self, DIR_LEFT);
-        }
+bool tetrion_poll_event(struct Tetrion *self, enum TetrionEvent *event) {
+    if (self->event_head >= self->event_count) {
+        self->event_head = 0;
+        self->event_count = 0;
 
-        if (input_key_down(state, SDL_SCANCODE_D) ||
-            input_key_down(state, SDL_SCANCODE_RIGHT)) {
-            move_piece(self, DIR_RIGHT);
-        }
+        return false;
+    }
 
-        if (input_key_released(state, SDL_SCANCODE_E)) {
-            rotate_piece_90(self);
-        }
+    *event = self->events[self->event_head++];
+    self->pending_events &= ~(1u << *event);
 
-        if (input_key_released(state, SDL_SCANCODE_Q)) {
-            rotate_piece_90_cnt(self);
-        }
+    return true;
+}
+
+void tetrion_add_garbage(struct Tetrion *self, int rows, int hole) {
+    if ((self->state != TETRION_STATE_NORMAL &&
+         self->state != TETRION_STATE_UPDATING_ROWS) ||
+        rows <= 0) {
+        return;
     }
 
-    if (self->state == TETRION_STATE_NORMAL ||
-        self->state == TETRION_STATE_UPDATING_ROWS) {
-        if (input_key_pressed(state, SDL_SCANCODE_S) ||
-            input_key_pressed(state, SDL_SCANCODE_DOWN)) {
-            speed_up_fall(self);
-        } else if (input_key_released(state, SDL_SCANCODE_S) ||
-                   input_key_released(state, SDL_SCANCODE_DOWN)) {
-            slow_down_fall(self);
-        }
+    ++self->generation;
 
-        if (input_key_pressed(state, SDL_SCANCODE_SPACE)) {
-            drop_piece(self);
-        }
+    if (board_add_garbage(&self->board, rows, hole) > 0) {
+        self->state = TETRION_STATE_GAME_OVER;
+
+        push_event(self, TETRION_EVENT_GAME_OVER);
+
+        return;
     }
+
+    /* If there's no room even at the top, the next tick ends the game */
+    for (int i = 0; i < rows && !piece_fits(self); ++i) {
+        --self->piece.pos.y;
+    }
+
+    push_event(self, TETRION_EVENT_MOVED);
 }
 
-void tetrion_handle_pause(struct Tetrion *self) { slow_down_fall(self); }
+void tetrion_snapshot(
+    const struct Tetrion *self, struct TetrionSnapshot *snapshot
+) {
+    const struct Randomizer *randomizer = &self->randomizer;
+
+    snapshot->time = self->time;
+    snapshot->rng = randomizer->rng;
+    memcpy(snapshot->rows, self->board.rows, sizeof(snapshot->rows));
+    memcpy(snapshot->colors, self->board.colors, sizeof(snapshot->colors));
+    snapshot->score = self->score;
+    snapshot->lines = (uint32_t)self->lines;
+    snapshot->ticker_elapsed =
+        saturate_u32(timer_elapsed(&self->ticker, self->time));
+    snapshot->clear_timer_elapsed =
+        saturate_u32(timer_elapsed(&self->clear_timer, self->time));
+    snapshot->fall_interval = saturate_u32(self->ticker.interval);
+    snapshot->saved_fall_interval = saturate_u32(self->saved_fall_interval);
+    snapshot->level = (uint16_t)self->level;
+    snapshot->piece_x = (int8_t)self->piece.pos.x;
+    snapshot->piece_y = (int8_t)self->piece.pos.y;
+    snapshot->piece_id = (uint8_t)self->piece.id;
+    snapshot->piece_rotation = (uint8_t)self->piece.rotation;
+    snapshot->state = (uint8_t)self->state;
+    memcpy(snapshot->bag, randomizer->bag, sizeof(snapshot->bag));
+    snapshot->bag_left = randomizer->bag_left;
+    snapshot->flags = (uint8_t)((self->dropped ? SNAPSHOT_DROPPED : 0) |
+                                (self->lock_saved_fall_interval
+                                     ? SNAPSHOT_LOCK_SAVED_FALL_INTERVAL
+                                     : 0));
+    memset(snapshot->preview, 0, sizeof(snapshot->preview));
+
+    for (int i = 0; i < self->config.preview; ++i) {
+        snapshot->preview[i] = (uint8_t)self->preview[i].id;
+    }
+}
 
-void tetrion_render(
-    struct Tetrion *self, struct SDL_Renderer *renderer, struct TileSet *tileset
+void tetrion_restore(
+    struct Tetrion *self, const struct TetrionSnapshot *snapshot
 ) {
-    for (int y = 0; y < (int)self->rect.h; ++y) {
-        for (int x = 0; x < (int)self->rect.w; ++x) {
-            int tile_x = TILE_WIDTH * (self->rect.x + x);
-            int tile_y = TILE_HEIGHT * (self->rect.y + y);
+    struct Randomizer *randomizer = &self->randomizer;
+
+    self->time = snapshot->time;
+    randomizer->rng = snapshot->rng;
+    board_clear(&self->board);
+    memcpy(self->board.rows, snapshot->rows, sizeof(snapshot->rows));
+    memcpy(self->board.colors, snapshot->colors, sizeof(snapshot->colors));
+    board_update_heights(&self->board);
+    board_update_hash(&self->board);
+    ++self->generation;
+    self->score = snapshot->score;
+    self->lines = (int)snapshot->lines;
+    self->ticker.start_time = snapshot->time - snapshot->ticker_elapsed;
+    self->ticker.interval = snapshot->fall_interval;
+    self->clear_timer.start_time =
+        snapshot->time - snapshot->clear_timer_elapsed;
+    self->clear_timer.interval = ms_to_ticks(self, self->config.clear_delay);
+    self->saved_fall_interval = snapshot->saved_fall_interval;
+    self->level = snapshot->level;
+    self->piece.id = (enum PieceId)snapshot->piece_id;
+    self->piece.rotation = snapshot->piece_rotation;
+    self->piece.pos.x = snapshot->piece_x;
+    self->piece.pos.y = snapshot->piece_y;
+
+    for (int i = 0; i < self->config.preview; ++i) {
+        self->preview[i] =
+            board_spawn_piece((enum PieceId)snapshot->preview[i]);
+    }
 
-            tileset_render_tile(
-                tileset, renderer, self->tilemap[y][x], tile_x, tile_y
-            );
+    self->state = (enum TetrionState)snapshot->state;
+    memcpy(randomizer->bag, snapshot->bag, sizeof(randomizer->bag));
+    randomizer->bag_left = snapshot->bag_left;
+    self->dropped = snapshot->flags & SNAPSHOT_DROPPED;
+    self->lock_saved_fall_interval =
+        snapshot->flags & SNAPSHOT_LOCK_SAVED_FALL_INTERVAL;
+
+    /* Let the frontend catch up with the restored state */
+    self->event_count = 0;
+    self->event_head = 0;
+    self->pending_events = 0;
+
+    push_event(self, TETRION_EVENT_SCORE_CHANGED);
+    push_event(self, TETRION_EVENT_NEXT_PIECE);
+}
+
+bool tetrion_snapshot_valid(const struct TetrionSnapshot *snapshot) {
+    if (snapshot->piece_id >= TOTAL_PIECES ||
+        snapshot->piece_rotation >= PIECE_ROTATIONS ||
+        snapshot->state > TETRION_STATE_GAME_OVER ||
+        snapshot->bag_left > TOTAL_PIECES) {
+        return false;
+    }
+
+    for (int i = 0; i < TETRION_MAX_PREVIEW; ++i) {
+        if (snapshot->preview[i] >= TOTAL_PIECES) {
+            return false;
         }
     }
 
-    struct SDL_Point piece_pos = {
-        TILE_WIDTH * (self->rect.x + self->piece.pos.x),
-        TILE_HEIGHT * (self->rect.y + self->piece.pos.y)
-    };
+    for (int i = 0; i < snapshot->bag_left; ++i) {
+        if (snapshot->bag[i] >= TOTAL_PIECES) {
+            return false;
+        }
+    }
 
-    render_piece_shadow(self, renderer, tileset);
-    piece_render(&self->piece, renderer, tileset, piece_pos);
+    /* The walls keep the pieces inside, they must be there */
+    for (int y = 0; y < BOARD_HEIGHT - 1; ++y) {
+        if ((snapshot->rows[y] & BOARD_EMPTY_ROW) != BOARD_EMPTY_ROW) {
+            return false;
+        }
+    }
+
+    return true;
 }
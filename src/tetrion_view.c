@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#include <wetris/tetrion_view.h>
+#include <wetris/utils.h>
+
+static void render_piece_shadow(
+    const struct Tetrion *tetrion, struct SDL_Renderer *renderer,
+    struct TileSet *tileset, struct TileBatch *batch, int x, int y
+) {
+    const struct Piece *piece = &tetrion->piece;
+
+    for (int py = 0; py < PIECE_HEIGHT; ++py) {
+        int tile_y = piece->pos.y + py;
+
+        for (int px = 0; px < PIECE_WIDTH; ++px) {
+            int tile_x = piece->pos.x + px;
+
+            if (!piece_has_block(piece, px, py)) {
+                continue;
+            }
+
+            int end = board_next_occupied(&tetrion->board, tile_x, tile_y);
+
+            for (int i = tile_y + 1; i < end; ++i) {
+                tileset_batch_tile(
+                    tileset, batch, renderer, TILE_FINAL_POS,
+                    x + TILE_WIDTH * tile_x, y + TILE_HEIGHT * i
+                );
+            }
+        }
+    }
+}
+
+static void render_board(
+    struct TetrionView *self, const struct Tetrion *tetrion,
+    SDL_Renderer *renderer, struct TileSet *tileset, struct TileBatch *batch
+) {
+    SDL_Texture *target = SDL_GetRenderTarget(renderer);
+
+    /* The tiles queued so far belong to the old target */
+    tileset_render_batch(tileset, batch, renderer);
+
+    if (!SDL_SetRenderTarget(renderer, self->board)) {
+        log_sdl_error();
+
+        return;
+    }
+
+    SDL_SetRenderDrawColor(renderer, 0x00, 0x00, 0x00, 0x00);
+    SDL_RenderClear(renderer);
+
+    for (int tile_y = 0; tile_y < BOARD_HEIGHT; ++tile_y) {
+        bool flash = (self->flashed_rows >> tile_y) & 1u;
+
+        for (int tile_x = 0; tile_x < BOARD_WIDTH; ++tile_x) {
+            enum TileId tile = board_tile(&tetrion->board, tile_x, tile_y);
+
+            if (flash && tile_is_block(tile)) {
+                tile = TILE_WHITE;
+            }
+
+            tileset_batch_tile(
+                tileset, batch, renderer, tile, TILE_WIDTH * tile_x,
+                TILE_HEIGHT * tile_y
+            );
+        }
+    }
+
+    tileset_render_batch(tileset, batch, renderer);
+    SDL_SetRenderTarget(renderer, target);
+}
+
+bool tetrion_view_init(struct TetrionView *self, SDL_Renderer *renderer) {
+    self->board = SDL_CreateTexture(
+        renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+        BOARD_WIDTH * TILE_WIDTH, BOARD_HEIGHT * TILE_HEIGHT
+    );
+    self->valid = false;
+
+    if (!self->board) {
+        log_sdl_error();
+
+        return false;
+    }
+
+    SDL_SetTextureBlendMode(self->board, SDL_BLENDMODE_BLEND);
+    SDL_SetTextureScaleMode(self->board, SDL_SCALEMODE_NEAREST);
+
+    return true;
+}
+
+void tetrion_view_deinit(struct TetrionView *self) {
+    if (!self) {
+        return;
+    }
+
+    SDL_DestroyTexture(self->board);
+    self->board = NULL;
+}
+
+void tetrion_view_invalidate(struct TetrionView *self) {
+    self->valid = false;
+}
+
+void tetrion_view_render(
+    struct TetrionView *self, const struct Tetrion *tetrion,
+    SDL_Renderer *renderer, struct TileSet *tileset, struct TileBatch *batch,
+    int x, int y
+) {
+    /* Rows waiting to be deleted are flashed */
+    uint32_t flashed_rows = tetrion->state == TETRION_STATE_UPDATING_ROWS
+                                ? board_full_rows(&tetrion->board)
+                                : 0;
+
+    if (!self->valid || self->generation != tetrion->generation ||
+        self->flashed_rows != flashed_rows) {
+        self->generation = tetrion->generation;
+        self->flashed_rows = flashed_rows;
+        self->valid = true;
+        render_board(self, tetrion, renderer, tileset, batch);
+    }
+
+    SDL_FRect dest = {
+        (float)x, (float)y, BOARD_WIDTH * TILE_WIDTH, BOARD_HEIGHT * TILE_HEIGHT
+    };
+
+    SDL_RenderTexture(renderer, self->board, NULL, &dest);
+
+    render_piece_shadow(tetrion, renderer, tileset, batch, x, y);
+    tileset_batch_piece(
+        tileset, batch, renderer, &tetrion->piece,
+        x + TILE_WIDTH * tetrion->piece.pos.x,
+        y + TILE_HEIGHT * tetrion->piece.pos.y
+    );
+}
@@ -12,40 +12,100 @@
 
 static char g_temp_buf[TEMP_BUF_SIZE];
 
-static void render_left_aligned(const struct Text *self, int x, int y) {
-    font_render_str(self->font, self->data, x, y, self->fg);
-}
+static bool reserve_quads(struct Text *self, size_t count) {
+    if (count <= self->quad_capacity) {
+        return true;
+    }
 
-static void render_center_aligned(const struct Text *self, int x, int y) {
-    const int initial_x = x;
+    SDL_Vertex *vertices =
+        mem_realloc(self->vertices, count * 4 * sizeof(SDL_Vertex));
 
-    for (size_t i = 0; i < self->line_count; ++i) {
-        const struct Line *line = &self->lines[i];
+    if (!vertices) {
+        return false;
+    }
 
-        x += self->rect.w / 2 - line->w / 2;
+    self->vertices = vertices;
 
-        font_render_str_n(self->font, line->begin, line->len, x, y, self->fg);
+    int *indices = mem_realloc(self->indices, count * 6 * sizeof(int));
 
-        y += line->h;
-        x = initial_x;
+    if (!indices) {
+        return false;
+    }
+
+    self->indices = indices;
+
+    /* Two triangles per glyph */
+    for (size_t i = self->quad_capacity; i < count; ++i) {
+        int *quad = &self->indices[i * 6];
+        int first = (int)i * 4;
+
+        quad[0] = first;
+        quad[1] = first + 1;
+        quad[2] = first + 2;
+        quad[3] = first + 2;
+        quad[4] = first + 3;
+        quad[5] = first;
     }
-}
 
-static void render_right_aligned(const struct Text *self, int x, int y) {
-    const int initial_x = x;
+    self->quad_capacity = count;
 
+    return true;
+}
+
+static void build_lines(struct Text *self, int x, int y) {
     for (size_t i = 0; i < self->line_count; ++i) {
         const struct Line *line = &self->lines[i];
+        int line_x = x;
 
-        x += self->rect.w - line->w;
+        if (self->align == TEXT_ALIGN_CENTER) {
+            line_x += self->rect.w / 2 - line->w / 2;
+        } else {
+            line_x += self->rect.w - line->w;
+        }
 
-        font_render_str_n(self->font, line->begin, line->len, x, y, self->fg);
+        self->quad_count += font_build_str_n(
+            self->font, line->begin, line->len, line_x, y, self->fg,
+            &self->vertices[self->quad_count * 4]
+        );
 
         y += line->h;
-        x = initial_x;
     }
 }
 
+/* Lays out the glyphs of the text at its current position and color. */
+static bool build_quads(struct Text *self) {
+    if (!reserve_quads(self, self->len)) {
+        return false;
+    }
+
+    int x = self->rect.x;
+    int y = self->rect.y;
+
+    self->quad_count = 0;
+
+    if (self->align == TEXT_ALIGN_LEFT) {
+        self->quad_count = font_build_str_n(
+            self->font, self->data, self->len, x, y, self->fg, self->vertices
+        );
+    } else {
+        build_lines(self, x, y);
+    }
+
+    self->built_x = x;
+    self->built_y = y;
+    self->built_fg = self->fg;
+    self->stale = false;
+
+    return true;
+}
+
+static bool needs_build(const struct Text *self) {
+    return self->stale || self->built_x != self->rect.x ||
+           self->built_y != self->rect.y || self->built_fg.r != self->fg.r ||
+           self->built_fg.g != self->fg.g || self->built_fg.b != self->fg.b ||
+           self->built_fg.a != self->fg.a;
+}
+
 static bool map_lines(struct Text *self) {
     /* TODO: this code would be better if we introduce a vector (dynamic array). */
 
@@ -103,9 +163,19 @@ void text_init(
     self->font = font;
     self->align = align;
     self->data = NULL;
+    self->len = 0;
+    self->capacity = 0;
     self->lines = NULL;
+    self->line_count = 0;
+    self->line_capacity = 0;
+    self->vertices = NULL;
+    self->indices = NULL;
+    self->quad_count = 0;
+    self->quad_capacity = 0;
+    self->rect = (SDL_Rect){0};
     self->fg = fg;
     self->show = true;
+    self->stale = true;
 }
 
 void text_deinit(struct Text *self) {
@@ -120,29 +190,36 @@ void text_deinit(struct Text *self) {
 
     mem_free(self->data);
     self->data = NULL;
+    self->len = 0;
+    self->capacity = 0;
+
+    mem_free(self->vertices);
+    self->vertices = NULL;
+    mem_free(self->indices);
+    self->indices = NULL;
+    self->quad_count = 0;
+    self->quad_capacity = 0;
+    self->stale = true;
 }
 
 void text_render(struct Text *self) {
-    if (!self->show) {
+    if (!self->show || !self->data) {
         return;
     }
 
-    int x = self->rect.x;
-    int y = self->rect.y;
-
-    switch (self->align) {
-    case TEXT_ALIGN_LEFT:
-        render_left_aligned(self, x, y);
-
-        break;
-    case TEXT_ALIGN_CENTER:
-        render_center_aligned(self, x, y);
+    if (needs_build(self) && !build_quads(self)) {
+        return;
+    }
 
-        break;
-    case TEXT_ALIGN_RIGHT:
-        render_right_aligned(self, x, y);
+    if (self->quad_count == 0) {
+        return;
+    }
 
-        break;
+    if (!SDL_RenderGeometry(
+            self->font->renderer, self->font->glyph_atlas, self->vertices,
+            self->quad_count * 4, self->indices, self->quad_count * 6
+        )) {
+        log_sdl_error();
     }
 }
 
@@ -160,29 +237,26 @@ bool text_vset(struct Text *self, const char *fmt, va_list vargs) {
     SDL_vsnprintf(g_temp_buf, TEMP_BUF_SIZE, fmt, vargs);
 
     size_t len = strlen(g_temp_buf) + 1;
-    self->data = mem_realloc(self->data, len);
 
-    if (!self->data) {
-        return false;
+    /* Kept between sets, so a text of the same size isn't reallocated */
+    if (len > self->capacity) {
+        char *data = mem_realloc(self->data, len);
+
+        if (!data) {
+            return false;
+        }
+
+        self->data = data;
+        self->capacity = len;
     }
 
-    strncpy(self->data, g_temp_buf, len);
+    memcpy(self->data, g_temp_buf, len);
 
     self->len = len - 1;
-    font_measure(self->font, fmt, &self->rect.w, &self->rect.h);
-
-    /* TODO: this code would be better if we introduce a vector abstraction (dynamic array). */
+    self->stale = true;
+    font_measure(self->font, self->data, &self->rect.w, &self->rect.h);
 
     self->line_count = 0;
-    self->line_capacity = 5;
-    self->lines =
-        mem_realloc(self->lines, self->line_capacity * sizeof(struct Line));
-
-    if (!self->lines) {
-        text_deinit(self);
-
-        return false;
-    }
 
     return map_lines(self);
 }
@@ -11,17 +11,6 @@
 bool tileset_load(
     struct TileSet *tileset, SDL_Renderer *renderer, const char *path
 ) {
-    /* We're starting with 1 because we want to skip TILE_NULL, which doesn't
-     * have its own texture */
-    for (int i = 0; i < TOTAL_TILES; ++i) {
-        SDL_FRect *r = &tileset->rects[i];
-
-        r->x = (float)i * TILE_WIDTH;
-        r->y = 0;
-        r->w = TILE_WIDTH;
-        r->h = TILE_HEIGHT;
-    }
-
     tileset->texture = IMG_LoadTexture(renderer, path);
 
     if (!tileset->texture) {
@@ -30,6 +19,25 @@ bool tileset_load(
         return false;
     }
 
+    float width;
+    float height;
+
+    if (!SDL_GetTextureSize(tileset->texture, &width, &height)) {
+        log_sdl_error();
+
+        return false;
+    }
+
+    /* TILE_NULL doesn't have its own texture, so the first one is skipped */
+    for (int i = 0; i < TOTAL_TILES - 1; ++i) {
+        SDL_FRect *r = &tileset->rects[i];
+
+        r->x = (float)(i * TILE_WIDTH) / width;
+        r->y = 0;
+        r->w = TILE_WIDTH / width;
+        r->h = TILE_HEIGHT / height;
+    }
+
     return true;
 }
 
@@ -42,26 +50,87 @@ void tileset_deinit(struct TileSet *tileset) {
     tileset->texture = NULL;
 }
 
-void tileset_render_tile(
-    struct TileSet *tileset, SDL_Renderer *renderer, enum TileId id, int x,
-    int y
+void tileset_batch_tile(
+    struct TileSet *tileset, struct TileBatch *batch, SDL_Renderer *renderer,
+    enum TileId id, int x, int y
 ) {
     if (id == TILE_NULL) {
         return;
     }
 
+    if (batch->count == TILE_BATCH_CAPACITY) {
+        tileset_render_batch(tileset, batch, renderer);
+    }
+
     /* Skip TILE_NULL */
-    --id;
+    const SDL_FRect *src = &tileset->rects[id - 1];
+    SDL_Vertex *v = &batch->vertices[batch->count * 4];
+    SDL_FColor white = {1.0f, 1.0f, 1.0f, 1.0f};
+    float left = (float)x;
+    float top = (float)y;
+    float right = left + TILE_WIDTH;
+    float bottom = top + TILE_HEIGHT;
 
-    SDL_FRect texture_portion = tileset->rects[id];
-    SDL_FRect screen_dest;
+    v[0] = (SDL_Vertex){{left, top}, white, {src->x, src->y}};
+    v[1] = (SDL_Vertex){{right, top}, white, {src->x + src->w, src->y}};
+    v[2] = (SDL_Vertex){
+        {right, bottom}, white, {src->x + src->w, src->y + src->h}
+    };
+    v[3] = (SDL_Vertex){{left, bottom}, white, {src->x, src->y + src->h}};
 
-    screen_dest.x = (float)x;
-    screen_dest.y = (float)y;
-    screen_dest.w = TILE_WIDTH;
-    screen_dest.h = TILE_HEIGHT;
+    ++batch->count;
+}
+
+void tileset_batch_piece(
+    struct TileSet *tileset, struct TileBatch *batch, SDL_Renderer *renderer,
+    const struct Piece *piece, int x, int y
+) {
+    enum TileId tile = piece_tile(piece->id);
+
+    for (int tile_y = 0; tile_y < PIECE_HEIGHT; ++tile_y) {
+        for (int tile_x = 0; tile_x < PIECE_WIDTH; ++tile_x) {
+            if (!piece_has_block(piece, tile_x, tile_y)) {
+                continue;
+            }
+
+            tileset_batch_tile(
+                tileset, batch, renderer, tile, x + tile_x * TILE_WIDTH,
+                y + tile_y * TILE_HEIGHT
+            );
+        }
+    }
+}
+
+void tileset_render_batch(
+    struct TileSet *tileset, struct TileBatch *batch, SDL_Renderer *renderer
+) {
+    if (batch->count == 0) {
+        return;
+    }
+
+    if (!SDL_RenderGeometry(
+            renderer, tileset->texture, batch->vertices, batch->count * 4,
+            batch->indices, batch->count * 6
+        )) {
+        log_sdl_error();
+    }
+
+    batch->count = 0;
+}
+
+void tile_batch_init(struct TileBatch *self) {
+    /* Two triangles per tile */
+    for (int i = 0; i < TILE_BATCH_CAPACITY; ++i) {
+        int *indices = &self->indices[i * 6];
+        int first = i * 4;
+
+        indices[0] = first;
+        indices[1] = first + 1;
+        indices[2] = first + 2;
+        indices[3] = first + 2;
+        indices[4] = first + 3;
+        indices[5] = first;
+    }
 
-    SDL_RenderTexture(
-        renderer, tileset->texture, &texture_portion, &screen_dest
-    );
+    self->count = 0;
 }
@@ -6,23 +6,23 @@
 
 #include <wetris/timer.h>
 
-#include <SDL3/SDL.h>
-
-struct Timer timer_new(uint64_t interval) {
+struct Timer timer_new(uint64_t interval, uint64_t now) {
     struct Timer timer = {
-        .start_time = SDL_GetTicks(),
+        .start_time = now,
         .interval = interval,
     };
 
     return timer;
 }
 
-void timer_restart(struct Timer *self) { self->start_time = SDL_GetTicks(); }
+void timer_restart(struct Timer *self, uint64_t now) {
+    self->start_time = now;
+}
 
-uint64_t timer_elapsed(const struct Timer *self) {
-    return SDL_GetTicks() - self->start_time;
+uint64_t timer_elapsed(const struct Timer *self, uint64_t now) {
+    return now - self->start_time;
 }
 
-bool timer_done(const struct Timer *self) {
-    return timer_elapsed(self) >= self->interval;
+bool timer_done(const struct Timer *self, uint64_t now) {
+    return timer_elapsed(self, now) >= self->interval;
 }
@@ -0,0 +1,389 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+/*
+ * Runs many headless games on every core and reports how each one went and
+ * the aggregate throughput. The games are either played by the bot or played
+ * back from replays. With a beam search the games are played one by one
+ * instead, and every search is spread over the cores.
+ */
+
+#include <wetris/bot.h>
+#include <wetris/planner.h>
+#include <wetris/pool.h>
+#include <wetris/replay.h>
+#include <wetris/rng.h>
+#include <wetris/tetrion.h>
+#include <wetris/trans_table.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_GAMES 64
+#define DEFAULT_TICK_LIMIT 600000 /* 10 minutes at the default tick rate */
+
+struct Options {
+    int threads;
+    int games;
+    uint64_t tick_limit;
+    uint64_t seed;
+    enum RandomizerKind randomizer;
+    size_t table_size; /* MB, 0 for no transposition table */
+    int preview;       /* 0 to match the depth of the planner */
+    struct PlannerConfig planner;
+    bool beam;
+    char **replays;
+    int replay_count;
+};
+
+struct GameResult {
+    uint64_t seed;
+    int score;
+    int level;
+    uint64_t pieces;
+    uint64_t ticks;
+    bool game_over;
+    bool failed;
+};
+
+struct Farm {
+    const struct Options *options;
+    struct GameResult *results;
+    struct TransTable *table; /* shared by all the bots */
+    struct Planner *planner;  /* when the games are played one by one */
+};
+
+static void usage(const char *name) {
+    fprintf(
+        stderr,
+        "usage: %s [-j THREADS] [-n GAMES] [-t TICKS] [-s SEED] [--bag] "
+        "[--tt MB] [--preview N] [--beam WIDTH] [--depth N] [--budget MS] "
+        "[REPLAY...]\n",
+        name
+    );
+}
+
+static bool parse_args(int argc, char *argv[], struct Options *options) {
+    options->threads = 0;
+    options->games = DEFAULT_GAMES;
+    options->tick_limit = DEFAULT_TICK_LIMIT;
+    options->seed = (uint64_t)time(NULL);
+    options->randomizer = RANDOMIZER_RANDOM;
+    options->table_size = 0;
+    options->preview = 0;
+    options->planner = planner_config_default();
+    options->beam = false;
+    options->replays = NULL;
+    options->replay_count = 0;
+
+    int i = 1;
+
+    for (; i < argc && argv[i][0] == '-'; ++i) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            options->threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            options->games = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            options->tick_limit = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            options->seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--bag") == 0) {
+            options->randomizer = RANDOMIZER_BAG;
+        } else if (strcmp(argv[i], "--tt") == 0 && i + 1 < argc) {
+            options->table_size = (size_t)strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--preview") == 0 && i + 1 < argc) {
+            options->preview = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--beam") == 0 && i + 1 < argc) {
+            options->planner.beam_width = atoi(argv[++i]);
+            options->beam = true;
+        } else if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc) {
+            options->planner.depth = atoi(argv[++i]);
+            options->beam = true;
+        } else if (strcmp(argv[i], "--budget") == 0 && i + 1 < argc) {
+            options->planner.budget = strtoull(argv[++i], NULL, 10) * 1000000u;
+            options->beam = true;
+        } else {
+            return false;
+        }
+    }
+
+    if (i < argc) {
+        options->replays = &argv[i];
+        options->replay_count = argc - i;
+        options->games = options->replay_count;
+    }
+
+    if (options->preview == 0) {
+        options->preview = options->beam ? options->planner.depth - 1 : 1;
+        options->preview = options->preview < 1 ? 1 : options->preview;
+    }
+
+    return options->games > 0 && options->threads >= 0 &&
+           options->preview >= 1 && options->preview <= TETRION_MAX_PREVIEW &&
+           options->planner.beam_width > 0 && options->planner.depth > 0 &&
+           options->planner.depth <= PLANNER_MAX_DEPTH;
+}
+
+/*
+ * Counts the pieces locked, every one of them either landed or was dropped.
+ * A new piece isn't a locked one: resets and restarts announce one too.
+ */
+static uint64_t count_pieces(struct Tetrion *tetrion) {
+    uint64_t pieces = 0;
+    enum TetrionEvent event;
+
+    while (tetrion_poll_event(tetrion, &event)) {
+        pieces += event == TETRION_EVENT_LANDED ||
+                  event == TETRION_EVENT_DROPPED;
+    }
+
+    return pieces;
+}
+
+static void play_bot(
+    const struct Options *options, const struct Farm *farm,
+    struct GameResult *result
+) {
+    struct TetrionConfig config = tetrion_config_default();
+    config.seed = result->seed;
+    config.randomizer = options->randomizer;
+    config.preview = options->preview;
+
+    struct Tetrion tetrion;
+    tetrion_init(&tetrion, &config);
+    tetrion_apply(&tetrion, TETRION_ACTION_START);
+
+    struct BotWeights weights = bot_weights_default();
+    struct BotPlayer player;
+    bot_player_init(&player, &weights);
+    player.table = farm->table;
+    player.planner = farm->planner;
+
+    while (tetrion.state != TETRION_STATE_GAME_OVER &&
+           tetrion.time < options->tick_limit) {
+        bot_player_tick(&player, &tetrion);
+        result->pieces += count_pieces(&tetrion);
+    }
+
+    result->score = tetrion.score;
+    result->level = tetrion.level;
+    result->ticks = tetrion.time;
+    result->game_over = tetrion.state == TETRION_STATE_GAME_OVER;
+}
+
+static void play_replay(const char *path, struct GameResult *result) {
+    struct Replay replay;
+
+    if (!replay_load(&replay, path)) {
+        result->failed = true;
+
+        return;
+    }
+
+    struct Tetrion tetrion;
+    struct ReplayPlayer player;
+
+    tetrion_init(&tetrion, &replay.config);
+    replay_player_init(&player, &replay);
+
+    while (tetrion.time < replay.duration) {
+        replay_player_advance(&player, &tetrion, tetrion.time + 1);
+        result->pieces += count_pieces(&tetrion);
+    }
+
+    result->seed = replay.config.seed;
+    result->score = tetrion.score;
+    result->level = tetrion.level;
+    result->ticks = tetrion.time;
+    result->game_over = tetrion.state == TETRION_STATE_GAME_OVER;
+
+    replay_deinit(&replay);
+}
+
+static void play(void *ctx, int index, int worker) {
+    (void)worker;
+
+    struct Farm *farm = ctx;
+    const struct Options *options = farm->options;
+    struct GameResult *result = &farm->results[index];
+
+    if (options->replays) {
+        play_replay(options->replays[index], result);
+    } else {
+        play_bot(options, farm, result);
+    }
+}
+
+static double now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void print_result(
+    const struct Options *options, int index, const struct GameResult *result
+) {
+    const char *name = options->replays ? options->replays[index] : "game";
+
+    if (result->failed) {
+        fprintf(stderr, "%s: cannot load the replay\n", name);
+
+        return;
+    }
+
+    printf(
+        "%s %d: seed %llu, score %d, level %d, %llu pieces, %llu ticks%s\n",
+        name, index, (unsigned long long)result->seed, result->score,
+        result->level, (unsigned long long)result->pieces,
+        (unsigned long long)result->ticks,
+        result->game_over ? ", game over" : ""
+    );
+}
+
+int main(int argc, char *argv[]) {
+    struct Options options;
+
+    if (!parse_args(argc, argv, &options)) {
+        usage(argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    struct Farm farm = {
+        .options = &options,
+        .results = calloc((size_t)options.games, sizeof(struct GameResult)),
+        .table = NULL,
+        .planner = NULL,
+    };
+
+    if (!farm.results) {
+        fprintf(stderr, "out of memory\n");
+
+        return EXIT_FAILURE;
+    }
+
+    /* Every game gets its own seed, derived from the farm one */
+    struct Rng rng;
+    rng_seed(&rng, options.seed);
+
+    for (int i = 0; i < options.games; ++i) {
+        farm.results[i].seed = rng_next64(&rng);
+    }
+
+    struct TransTable table;
+
+    if (options.table_size > 0 && !options.replays) {
+        if (!trans_table_init(&table, options.table_size)) {
+            fprintf(stderr, "cannot allocate the transposition table\n");
+            free(farm.results);
+
+            return EXIT_FAILURE;
+        }
+
+        farm.table = &table;
+    }
+
+    struct Pool pool;
+
+    if (!pool_init(&pool, options.threads)) {
+        fprintf(stderr, "cannot start the worker threads\n");
+
+        if (farm.table) {
+            trans_table_deinit(farm.table);
+        }
+
+        free(farm.results);
+
+        return EXIT_FAILURE;
+    }
+
+    struct Planner planner;
+
+    if (options.beam && !options.replays) {
+        if (!planner_init(&planner, &pool, &options.planner)) {
+            fprintf(stderr, "out of memory\n");
+            pool_deinit(&pool);
+
+            if (farm.table) {
+                trans_table_deinit(farm.table);
+            }
+
+            free(farm.results);
+
+            return EXIT_FAILURE;
+        }
+
+        planner.table = farm.table;
+        farm.planner = &planner;
+    }
+
+    double start = now();
+
+    if (farm.planner) {
+        for (int i = 0; i < options.games; ++i) {
+            play(&farm, i, 0);
+        }
+    } else {
+        pool_run(&pool, options.games, play, &farm);
+    }
+
+    double elapsed = now() - start;
+
+    int failed = 0;
+    uint64_t pieces = 0;
+    uint64_t ticks = 0;
+
+    for (int i = 0; i < options.games; ++i) {
+        const struct GameResult *result = &farm.results[i];
+
+        print_result(&options, i, result);
+        failed += result->failed;
+        pieces += result->pieces;
+        ticks += result->ticks;
+    }
+
+    int games = options.games - failed;
+
+    printf(
+        "%d games on %d threads in %.3f s: %.1f games/s, %.0f pieces/s, "
+        "%.0f ticks/s\n",
+        games, pool.size, elapsed, games / elapsed, (double)pieces / elapsed,
+        (double)ticks / elapsed
+    );
+
+    if (farm.table) {
+        struct TransTableStats stats;
+        trans_table_stats(farm.table, &stats);
+
+        printf(
+            "transposition table: %llu probes, %llu hits (%.1f%%), "
+            "%llu stores\n",
+            (unsigned long long)stats.probes, (unsigned long long)stats.hits,
+            100.0 * trans_table_hit_rate(farm.table),
+            (unsigned long long)stats.stores
+        );
+        trans_table_deinit(farm.table);
+    }
+
+    if (farm.planner) {
+        printf(
+            "beam width %d, depth %d: %.2f depths completed per search\n",
+            planner.config.beam_width, planner.config.depth,
+            planner.searches
+                ? (double)planner.depth_total / (double)planner.searches
+                : 0.0
+        );
+        planner_deinit(farm.planner);
+    }
+
+    pool_deinit(&pool);
+    free(farm.results);
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,537 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+/*
+ * Counts the distinct boards reachable by locking a sequence of pieces one
+ * after another, with the same moves, kicks and gravity as the player has (see
+ * bot_landings_find()), like perft does for chess move generators. Every depth
+ * is run on a single thread and then on all of them, both runs must agree.
+ * The known answers of --check catch changes of the collision and rotation
+ * code, the speed is the number to track when optimizing it.
+ */
+
+#include <wetris/bot.h>
+#include <wetris/pool.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_DEPTH 8
+#define PLAYFIELD_WIDTH (BOARD_WIDTH - 2)
+
+/* The occupancy of a board, what tells boards apart. */
+struct BoardRows {
+    uint16_t rows[BOARD_HEIGHT - 1];
+};
+
+/* Growable arrays of boards, of their rows and of their hashes. */
+struct Level {
+    struct Board *boards;
+    struct BoardRows *rows;
+    uint64_t *hashes;
+    size_t count;
+    size_t capacity;
+};
+
+struct PerftWorker {
+    struct BotLandings landings;
+    struct Level children;
+    uint64_t nodes;
+    bool out_of_memory;
+};
+
+struct Perft {
+    struct PerftWorker *workers;
+    const struct Level *level;
+    struct Piece piece;
+    bool keep_boards; /* false at the last depth, only the count matters */
+};
+
+struct HashSlot {
+    uint64_t hash;
+    const struct BoardRows *rows; /* NULL for an empty slot */
+};
+
+/*
+ * A set of boards, open addressing with linear probing. Boards with the same
+ * hash are compared row by row, so a collision can't merge two of them.
+ */
+struct HashSet {
+    struct HashSlot *slots;
+    size_t mask;
+    size_t count;
+};
+
+struct Position {
+    const char *name;
+    const char *board;
+    const char *pieces;
+    uint64_t boards[MAX_DEPTH]; /* distinct boards after each piece */
+};
+
+/*
+ * The answers for a single piece on the empty board are the well-known
+ * placement counts, the rest were recorded from the generator itself. The
+ * slot position can only be cleared twice with a T-spin.
+ */
+static const struct Position g_positions[] = {
+    {"empty I", "", "I", {17}},
+    {"empty O", "", "O", {9}},
+    {"empty T", "", "T", {34}},
+    {"empty S", "", "S", {17}},
+    {"empty Z", "", "Z", {17}},
+    {"empty J", "", "J", {34}},
+    {"empty L", "", "L", {34}},
+    {"empty TIO", "", "TIO", {34, 600, 5578}},
+    {"empty SZLJ", "", "SZLJ", {17, 296, 10586, 386484}},
+    {"t-spin slot", "###......./##...#####/###.######", "TZ", {37, 646}},
+    {"tucks", "......####/#........#/##.#.#.###", "LJI", {35, 1303, 25456}},
+};
+
+#define TOTAL_POSITIONS ((int)(sizeof(g_positions) / sizeof(g_positions[0])))
+
+static double now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static bool level_push(
+    struct Level *self, const struct Board *board, bool keep_board
+) {
+    if (self->count == self->capacity) {
+        size_t capacity = self->capacity ? self->capacity * 2 : 256;
+        uint64_t *hashes =
+            realloc(self->hashes, capacity * sizeof(*self->hashes));
+
+        if (!hashes) {
+            return false;
+        }
+
+        self->hashes = hashes;
+
+        struct BoardRows *rows =
+            realloc(self->rows, capacity * sizeof(*self->rows));
+
+        if (!rows) {
+            return false;
+        }
+
+        self->rows = rows;
+
+        if (keep_board) {
+            struct Board *boards =
+                realloc(self->boards, capacity * sizeof(*self->boards));
+
+            if (!boards) {
+                return false;
+            }
+
+            self->boards = boards;
+        }
+
+        self->capacity = capacity;
+    }
+
+    self->hashes[self->count] = board->hash;
+    memcpy(
+        self->rows[self->count].rows, board->rows,
+        sizeof(self->rows[self->count].rows)
+    );
+
+    if (keep_board) {
+        self->boards[self->count] = *board;
+    }
+
+    ++self->count;
+
+    return true;
+}
+
+static void level_free(struct Level *self) {
+    free(self->boards);
+    free(self->rows);
+    free(self->hashes);
+    memset(self, 0, sizeof(*self));
+}
+
+static bool hash_set_init(struct HashSet *self, size_t count) {
+    size_t capacity = 1024;
+
+    /* The load stays below a half */
+    while (capacity < count * 2) {
+        capacity *= 2;
+    }
+
+    self->slots = calloc(capacity, sizeof(*self->slots));
+    self->mask = capacity - 1;
+    self->count = 0;
+
+    return self->slots != NULL;
+}
+
+/*
+ * Returns whether the board wasn't there yet. The rows are referenced, not
+ * copied, they must outlive the set.
+ */
+static bool hash_set_insert(
+    struct HashSet *self, uint64_t hash, const struct BoardRows *rows
+) {
+    for (size_t i = hash & self->mask;; i = (i + 1) & self->mask) {
+        struct HashSlot *slot = &self->slots[i];
+
+        if (!slot->rows) {
+            slot->hash = hash;
+            slot->rows = rows;
+            ++self->count;
+
+            return true;
+        }
+
+        if (slot->hash == hash &&
+            memcmp(slot->rows, rows, sizeof(*rows)) == 0) {
+            return false;
+        }
+    }
+}
+
+static void expand(void *ctx, int index, int worker_index) {
+    struct Perft *perft = ctx;
+    struct PerftWorker *worker = &perft->workers[worker_index];
+    const struct Board *board = &perft->level->boards[index];
+
+    bot_landings_find(&worker->landings, board, &perft->piece);
+
+    for (int i = 0; i < worker->landings.count; ++i) {
+        struct Board child = *board;
+
+        bot_place(&child, &worker->landings.landings[i].piece);
+
+        if (!level_push(&worker->children, &child, perft->keep_boards)) {
+            worker->out_of_memory = true;
+        }
+    }
+
+    worker->nodes += (uint64_t)worker->landings.count;
+}
+
+/* Merges the children found by the workers into the next level. */
+static bool merge(
+    struct Perft *perft, int workers, bool keep_boards, struct Level *next,
+    uint64_t *nodes, uint64_t *distinct
+) {
+    size_t total = 0;
+
+    for (int i = 0; i < workers; ++i) {
+        total += perft->workers[i].children.count;
+    }
+
+    struct HashSet seen;
+
+    if (!hash_set_init(&seen, total)) {
+        return false;
+    }
+
+    bool ok = true;
+
+    for (int i = 0; i < workers; ++i) {
+        struct PerftWorker *worker = &perft->workers[i];
+
+        ok = ok && !worker->out_of_memory;
+        *nodes += worker->nodes;
+
+        for (size_t j = 0; ok && j < worker->children.count; ++j) {
+            const struct Level *children = &worker->children;
+
+            if (!hash_set_insert(
+                    &seen, children->hashes[j], &children->rows[j]
+                )) {
+                continue;
+            }
+
+            if (keep_boards) {
+                ok = level_push(next, &children->boards[j], true);
+            }
+        }
+    }
+
+    /* The set points into the children until here */
+    for (int i = 0; i < workers; ++i) {
+        struct PerftWorker *worker = &perft->workers[i];
+
+        level_free(&worker->children);
+        worker->nodes = 0;
+        worker->out_of_memory = false;
+    }
+
+    *distinct = seen.count;
+    free(seen.slots);
+
+    return ok;
+}
+
+/* Fills distinct with the number of boards after each piece. */
+static bool run(
+    struct Pool *pool, const struct Board *board, const enum PieceId *pieces,
+    int depth, uint64_t *distinct, uint64_t *nodes
+) {
+    struct Perft perft = {
+        .workers = calloc((size_t)pool->size, sizeof(struct PerftWorker)),
+    };
+
+    if (!perft.workers) {
+        return false;
+    }
+
+    struct Level level = {0};
+    bool ok = level_push(&level, board, true);
+
+    *nodes = 0;
+
+    for (int d = 0; ok && d < depth; ++d) {
+        struct Level next = {0};
+
+        perft.level = &level;
+        perft.piece = board_spawn_piece(pieces[d]);
+        perft.keep_boards = d + 1 < depth;
+
+        pool_run(pool, (int)level.count, expand, &perft);
+        ok = merge(
+            &perft, pool->size, perft.keep_boards, &next, nodes, &distinct[d]
+        );
+
+        level_free(&level);
+        level = next;
+    }
+
+    level_free(&level);
+    free(perft.workers);
+
+    return ok;
+}
+
+static bool parse_pieces(const char *text, enum PieceId *pieces, int *depth) {
+    static const char LETTERS[TOTAL_PIECES] = {
+        [PIECE_Z] = 'Z', [PIECE_L] = 'L', [PIECE_O] = 'O', [PIECE_S] = 'S',
+        [PIECE_J] = 'J', [PIECE_I] = 'I', [PIECE_T] = 'T',
+    };
+
+    *depth = 0;
+
+    for (; *text; ++text) {
+        const char *letter = memchr(LETTERS, *text, TOTAL_PIECES);
+
+        if (!letter || *depth == MAX_DEPTH) {
+            return false;
+        }
+
+        pieces[(*depth)++] = (enum PieceId)(letter - LETTERS);
+    }
+
+    return *depth > 0;
+}
+
+/*
+ * The rows are given from the top, separated by '/', and end up at the bottom
+ * of the board. '#' is an occupied cell, anything else an empty one.
+ */
+static bool parse_board(const char *text, struct Board *board) {
+    int rows = *text ? 1 : 0;
+
+    for (const char *c = text; *c; ++c) {
+        rows += *c == '/';
+    }
+
+    board_clear(board);
+
+    if (rows > BOARD_HEIGHT - 1) {
+        return false;
+    }
+
+    int y = BOARD_HEIGHT - 1 - rows;
+    int x = 1;
+
+    for (; *text; ++text) {
+        if (*text == '/') {
+            ++y;
+            x = 1;
+
+            continue;
+        }
+
+        if (x > PLAYFIELD_WIDTH) {
+            return false;
+        }
+
+        if (*text == '#') {
+            board_put(board, 0x1, x, y, TILE_WHITE);
+        }
+
+        ++x;
+    }
+
+    return true;
+}
+
+static void usage(const char *name) {
+    fprintf(
+        stderr,
+        "usage: %s [-j THREADS] [-b BOARD] PIECES\n"
+        "       %s [-j THREADS] --check\n",
+        name, name
+    );
+}
+
+/* Runs the position on one thread and on all of them, prints the counts. */
+static bool perft(
+    struct Pool *single, struct Pool *pool, const struct Board *board,
+    const enum PieceId *pieces, int depth, uint64_t *distinct
+) {
+    uint64_t counts[2][MAX_DEPTH];
+    uint64_t nodes[2];
+    double elapsed[2];
+    struct Pool *pools[2] = {single, pool};
+
+    for (int i = 0; i < 2; ++i) {
+        double start = now();
+
+        if (!run(pools[i], board, pieces, depth, counts[i], &nodes[i])) {
+            fprintf(stderr, "out of memory\n");
+
+            return false;
+        }
+
+        elapsed[i] = now() - start;
+    }
+
+    for (int d = 0; d < depth; ++d) {
+        printf(
+            "depth %d: %llu boards\n", d + 1, (unsigned long long)counts[0][d]
+        );
+    }
+
+    for (int i = 0; i < 2; ++i) {
+        printf(
+            "%d %s: %llu nodes in %.3f s, %.0f nodes/s\n", pools[i]->size,
+            pools[i]->size == 1 ? "thread" : "threads",
+            (unsigned long long)nodes[i], elapsed[i],
+            (double)nodes[i] / elapsed[i]
+        );
+    }
+
+    if (memcmp(counts[0], counts[1], (size_t)depth * sizeof(uint64_t)) != 0 ||
+        nodes[0] != nodes[1]) {
+        fprintf(stderr, "the single and multithreaded counts differ\n");
+
+        return false;
+    }
+
+    memcpy(distinct, counts[0], (size_t)depth * sizeof(uint64_t));
+
+    return true;
+}
+
+static bool check(struct Pool *single, struct Pool *pool) {
+    int failed = 0;
+
+    for (int i = 0; i < TOTAL_POSITIONS; ++i) {
+        const struct Position *position = &g_positions[i];
+        struct Board board;
+        enum PieceId pieces[MAX_DEPTH];
+        uint64_t distinct[MAX_DEPTH];
+        int depth;
+
+        printf("%s\n", position->name);
+
+        if (!parse_board(position->board, &board) ||
+            !parse_pieces(position->pieces, pieces, &depth) ||
+            !perft(single, pool, &board, pieces, depth, distinct)) {
+            ++failed;
+
+            continue;
+        }
+
+        for (int d = 0; d < depth; ++d) {
+            if (distinct[d] != position->boards[d]) {
+                printf(
+                    "FAILED at depth %d: expected %llu boards\n", d + 1,
+                    (unsigned long long)position->boards[d]
+                );
+                ++failed;
+
+                break;
+            }
+        }
+    }
+
+    printf(
+        "%d of %d positions passed\n", TOTAL_POSITIONS - failed,
+        TOTAL_POSITIONS
+    );
+
+    return failed == 0;
+}
+
+int main(int argc, char *argv[]) {
+    int threads = 0;
+    const char *board_text = "";
+    bool checking = false;
+    int i = 1;
+
+    for (; i < argc && argv[i][0] == '-'; ++i) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            board_text = argv[++i];
+        } else if (strcmp(argv[i], "--check") == 0) {
+            checking = true;
+        } else {
+            break;
+        }
+    }
+
+    struct Board board;
+    enum PieceId pieces[MAX_DEPTH];
+    int depth = 0;
+
+    if (threads < 0 ||
+        (!checking && (i + 1 != argc || !parse_board(board_text, &board) ||
+                       !parse_pieces(argv[i], pieces, &depth))) ||
+        (checking && i != argc)) {
+        usage(argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    struct Pool single;
+    struct Pool pool;
+
+    if (!pool_init(&single, 1)) {
+        fprintf(stderr, "cannot start the worker threads\n");
+
+        return EXIT_FAILURE;
+    }
+
+    if (!pool_init(&pool, threads)) {
+        fprintf(stderr, "cannot start the worker threads\n");
+        pool_deinit(&single);
+
+        return EXIT_FAILURE;
+    }
+
+    uint64_t distinct[MAX_DEPTH];
+    bool ok = checking
+                  ? check(&single, &pool)
+                  : perft(&single, &pool, &board, pieces, depth, distinct);
+
+    pool_deinit(&pool);
+    pool_deinit(&single);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
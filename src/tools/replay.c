@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+/*
+ * Plays replays back as fast as possible, without any window, and prints the
+ * outcome of each one. Useful to check whether a change of the rules alters
+ * recorded games.
+ *
+ * With -s the game is shown at the given tick instead, found through the
+ * keyframes, and --rewrite saves the replays again in the current format
+ * (e.g. to add keyframes to old ones).
+ */
+
+#include <wetris/replay.h>
+#include <wetris/tetrion.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static void usage(const char *name) {
+    fprintf(stderr, "usage: %s [-s TICK] [--rewrite] REPLAY...\n", name);
+}
+
+/*
+ * The loaded replay may be mapped from the file, so it's written next to it
+ * and then moved over it.
+ */
+static bool rewrite_replay(const struct Replay *replay, const char *path) {
+    char tmp_path[4096];
+
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path) >=
+            (int)sizeof(tmp_path) ||
+        !replay_save(replay, tmp_path)) {
+        return false;
+    }
+
+#ifdef _WIN32
+    /* rename() doesn't replace an existing file on Windows, elsewhere it does
+     * so atomically */
+    remove(path);
+#endif
+
+    return rename(tmp_path, path) == 0;
+}
+
+int main(int argc, char *argv[]) {
+    bool seeking = false;
+    bool rewrite = false;
+    uint64_t seek_time = 0;
+    int i = 1;
+
+    for (; i < argc && argv[i][0] == '-'; ++i) {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            seeking = true;
+            seek_time = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--rewrite") == 0) {
+            rewrite = true;
+        } else {
+            usage(argv[0]);
+
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (i == argc) {
+        usage(argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    int first = i;
+    int failed = 0;
+    uint64_t total_time = 0;
+    clock_t start = clock();
+
+    for (; i < argc; ++i) {
+        struct Replay replay;
+
+        if (!replay_load(&replay, argv[i])) {
+            fprintf(stderr, "%s: cannot load the replay\n", argv[i]);
+            ++failed;
+
+            continue;
+        }
+
+        struct Tetrion tetrion;
+        struct ReplayPlayer player;
+        uint64_t time = seeking && seek_time < replay.duration
+                            ? seek_time
+                            : replay.duration;
+
+        tetrion_init(&tetrion, &replay.config);
+        replay_player_init(&player, &replay);
+        replay_player_seek(&player, &tetrion, time);
+
+        printf(
+            "%s: score %d, level %d, %llu ticks%s", argv[i], tetrion.score,
+            tetrion.level, (unsigned long long)time,
+            tetrion.state == TETRION_STATE_GAME_OVER ? ", game over" : ""
+        );
+
+        if (replay.rules_version != TETRION_RULES_VERSION) {
+            printf(" (recorded with rules v%d)", replay.rules_version);
+        }
+
+        printf(", %u keyframes\n", replay.keyframe_count);
+
+        if (rewrite && !rewrite_replay(&replay, argv[i])) {
+            fprintf(stderr, "%s: cannot save the replay\n", argv[i]);
+            ++failed;
+        }
+
+        total_time += time;
+        replay_deinit(&replay);
+    }
+
+    double elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    printf(
+        "%d replays, %llu ticks of play in %.3f s\n", argc - first - failed,
+        (unsigned long long)total_time, elapsed
+    );
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,639 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+/*
+ * Tunes the weights of the bot with the separable CMA-ES (an evolution
+ * strategy adapting the step size and the variance of every weight, see Ros
+ * and Hansen, "A Simple Modification in CMA-ES Achieving Linear Time and Space
+ * Complexity"). Every candidate plays the same seeded headless games, all of
+ * them in parallel, and its fitness is the mean final score. The scoring of
+ * the games can be changed to tune for something else than the default score.
+ *
+ * The state of the search is saved to the checkpoint after every generation,
+ * and a run started with an existing checkpoint continues from there. The
+ * population, the games and the scoring are saved too, since the state is
+ * meaningless with other ones, so the run must be started with the same.
+ */
+
+#include <wetris/bot.h>
+#include <wetris/pool.h>
+#include <wetris/rng.h>
+#include <wetris/tetrion.h>
+
+#include <errno.h>
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DIMENSIONS 7 /* the fields of struct BotWeights */
+#define MAX_POPULATION 256
+#define DEFAULT_POPULATION 16
+#define DEFAULT_GAMES 8
+#define DEFAULT_GENERATIONS 50
+#define DEFAULT_TICK_LIMIT 300000 /* 5 minutes at the default tick rate */
+#define INITIAL_SIGMA 0.2
+
+#define CHECKPOINT_MAGIC "wetris-tune"
+#define CHECKPOINT_VERSION 2
+
+struct Options {
+    int threads;
+    int games;
+    int population;
+    int generations;
+    uint64_t tick_limit;
+    uint64_t seed;
+    enum RandomizerKind randomizer;
+    struct TetrionScoring scoring;
+    const char *checkpoint;
+};
+
+/* Everything needed to continue the search. */
+struct Search {
+    /* The options the search was started with */
+    int population;
+    int games;
+    struct TetrionScoring scoring;
+
+    int generation;
+    double sigma;
+    double mean[DIMENSIONS];
+    double variances[DIMENSIONS]; /* the diagonal of the covariance matrix */
+    double sigma_path[DIMENSIONS];
+    double variance_path[DIMENSIONS];
+    struct Rng rng;
+
+    double best_fitness;
+    double best[DIMENSIONS];
+};
+
+/* Constants of the strategy, derived from the population size. */
+struct Strategy {
+    int lambda;
+    int mu;
+    double weights[MAX_POPULATION];
+    double mu_eff;
+    double c_sigma;
+    double d_sigma;
+    double c_c;
+    double c_1;
+    double c_mu;
+    double chi_n; /* expected length of a N(0, I) vector */
+};
+
+struct Evaluation {
+    const struct Options *options;
+    double (*candidates)[DIMENSIONS];
+    uint64_t *seeds; /* one per game, shared by the candidates */
+    double *scores; /* population x games */
+};
+
+static void usage(const char *name) {
+    fprintf(
+        stderr,
+        "usage: %s [-j THREADS] [-g GAMES] [-p POPULATION] [-G GENERATIONS] "
+        "[-t TICKS] [-s SEED] [--bag] [--score ROW,LANDED,MOVE] "
+        "[CHECKPOINT]\n",
+        name
+    );
+}
+
+static bool parse_scoring(const char *text, struct TetrionScoring *scoring) {
+    return sscanf(
+               text, "%d,%d,%d", &scoring->row_deleted, &scoring->landed,
+               &scoring->move
+           ) == 3;
+}
+
+static bool parse_args(int argc, char *argv[], struct Options *options) {
+    options->threads = 0;
+    options->games = DEFAULT_GAMES;
+    options->population = DEFAULT_POPULATION;
+    options->generations = DEFAULT_GENERATIONS;
+    options->tick_limit = DEFAULT_TICK_LIMIT;
+    options->seed = (uint64_t)time(NULL);
+    options->randomizer = RANDOMIZER_RANDOM;
+    options->scoring = tetrion_scoring_default();
+    options->checkpoint = NULL;
+
+    int i = 1;
+
+    for (; i < argc && argv[i][0] == '-'; ++i) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            options->threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-g") == 0 && i + 1 < argc) {
+            options->games = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            options->population = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-G") == 0 && i + 1 < argc) {
+            options->generations = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            options->tick_limit = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            options->seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--bag") == 0) {
+            options->randomizer = RANDOMIZER_BAG;
+        } else if (strcmp(argv[i], "--score") == 0 && i + 1 < argc) {
+            if (!parse_scoring(argv[++i], &options->scoring)) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+
+    if (i + 1 == argc) {
+        options->checkpoint = argv[i];
+    } else if (i != argc) {
+        return false;
+    }
+
+    return options->threads >= 0 && options->games > 0 &&
+           options->population >= 4 &&
+           options->population <= MAX_POPULATION && options->generations > 0;
+}
+
+static struct BotWeights to_weights(const double *x) {
+    struct BotWeights weights = {
+        .holes = x[0],
+        .height = x[1],
+        .bumpiness = x[2],
+        .lines = x[3],
+        .row_transitions = x[4],
+        .column_transitions = x[5],
+        .wells = x[6],
+    };
+
+    return weights;
+}
+
+static void from_weights(const struct BotWeights *weights, double *x) {
+    x[0] = weights->holes;
+    x[1] = weights->height;
+    x[2] = weights->bumpiness;
+    x[3] = weights->lines;
+    x[4] = weights->row_transitions;
+    x[5] = weights->column_transitions;
+    x[6] = weights->wells;
+}
+
+/* A standard normal sample, with the Box-Muller transform. */
+static double gaussian(struct Rng *rng) {
+    /* Uniform in (0, 1], so the logarithm is always finite */
+    double u1 = (double)((rng_next64(rng) >> 11) + 1) * 0x1p-53;
+    double u2 = (double)(rng_next64(rng) >> 11) * 0x1p-53;
+
+    return sqrt(-2.0 * log(u1)) * cos(6.283185307179586 * u2);
+}
+
+static void strategy_init(struct Strategy *self, int lambda) {
+    double n = DIMENSIONS;
+    double sum = 0;
+    double sum_squares = 0;
+
+    self->lambda = lambda;
+    self->mu = lambda / 2;
+
+    for (int i = 0; i < self->mu; ++i) {
+        self->weights[i] = log(self->mu + 0.5) - log(i + 1.0);
+        sum += self->weights[i];
+    }
+
+    for (int i = 0; i < self->mu; ++i) {
+        self->weights[i] /= sum;
+        sum_squares += self->weights[i] * self->weights[i];
+    }
+
+    self->mu_eff = 1.0 / sum_squares;
+    self->c_sigma = (self->mu_eff + 2) / (n + self->mu_eff + 5);
+    self->d_sigma =
+        1 + 2 * fmax(0, sqrt((self->mu_eff - 1) / (n + 1)) - 1) + self->c_sigma;
+    self->c_c = (4 + self->mu_eff / n) / (n + 4 + 2 * self->mu_eff / n);
+
+    /* The separable variant can learn faster by a factor of (n + 2) / 3 */
+    double c_1 = 2 / ((n + 1.3) * (n + 1.3) + self->mu_eff);
+    double c_mu = fmin(
+        1 - c_1, 2 * (self->mu_eff - 2 + 1 / self->mu_eff) /
+                     ((n + 2) * (n + 2) + self->mu_eff)
+    );
+
+    self->c_1 = c_1 * (n + 2) / 3;
+    self->c_mu = fmin(1 - self->c_1, c_mu * (n + 2) / 3);
+    self->chi_n = sqrt(n) * (1 - 1 / (4 * n) + 1 / (21 * n * n));
+}
+
+static void search_init(struct Search *self, const struct Options *options) {
+    struct BotWeights weights = bot_weights_default();
+
+    self->population = options->population;
+    self->games = options->games;
+    self->scoring = options->scoring;
+    self->generation = 0;
+    self->sigma = INITIAL_SIGMA;
+    from_weights(&weights, self->mean);
+
+    for (int i = 0; i < DIMENSIONS; ++i) {
+        self->variances[i] = 1;
+        self->sigma_path[i] = 0;
+        self->variance_path[i] = 0;
+    }
+
+    rng_seed(&self->rng, options->seed);
+    self->best_fitness = -DBL_MAX;
+    memcpy(self->best, self->mean, sizeof(self->best));
+}
+
+static void write_vector(FILE *file, const char *name, const double *x) {
+    fprintf(file, "%s", name);
+
+    for (int i = 0; i < DIMENSIONS; ++i) {
+        fprintf(file, " %.17g", x[i]);
+    }
+
+    fprintf(file, "\n");
+}
+
+static bool read_vector(FILE *file, const char *name, double *x) {
+    char label[32];
+
+    if (fscanf(file, "%31s", label) != 1 || strcmp(label, name) != 0) {
+        return false;
+    }
+
+    for (int i = 0; i < DIMENSIONS; ++i) {
+        if (fscanf(file, "%lf", &x[i]) != 1) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ * The checkpoint is plain text, so it can be inspected (and the best weights
+ * copied) by hand. It's written to a temporary file first and then renamed
+ * over the old one, so an interrupted run never leaves a broken checkpoint.
+ */
+static bool save_checkpoint(const struct Search *self, const char *path) {
+    char tmp_path[4096];
+
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path) >=
+        (int)sizeof(tmp_path)) {
+        return false;
+    }
+
+    FILE *file = fopen(tmp_path, "w");
+
+    if (!file) {
+        return false;
+    }
+
+    fprintf(file, "%s %d\n", CHECKPOINT_MAGIC, CHECKPOINT_VERSION);
+    fprintf(file, "population %d\n", self->population);
+    fprintf(file, "games %d\n", self->games);
+    fprintf(
+        file, "scoring %d %d %d\n", self->scoring.row_deleted,
+        self->scoring.landed, self->scoring.move
+    );
+    fprintf(file, "generation %d\n", self->generation);
+    fprintf(file, "sigma %.17g\n", self->sigma);
+    write_vector(file, "mean", self->mean);
+    write_vector(file, "variances", self->variances);
+    write_vector(file, "sigma_path", self->sigma_path);
+    write_vector(file, "variance_path", self->variance_path);
+    fprintf(
+        file, "rng %u %u %u %u\n", self->rng.s[0], self->rng.s[1],
+        self->rng.s[2], self->rng.s[3]
+    );
+    fprintf(file, "best_fitness %.17g\n", self->best_fitness);
+    write_vector(file, "best", self->best);
+
+    bool ok = !ferror(file);
+
+    ok = fclose(file) == 0 && ok;
+
+    if (!ok) {
+        return false;
+    }
+
+#ifdef _WIN32
+    /* rename() doesn't replace an existing file on Windows, elsewhere it does
+     * so atomically */
+    remove(path);
+#endif
+
+    return rename(tmp_path, path) == 0;
+}
+
+/* Sets missing when there's no checkpoint yet, as opposed to a broken one. */
+static bool load_checkpoint(
+    struct Search *self, const char *path, bool *missing
+) {
+    FILE *file = fopen(path, "r");
+
+    *missing = !file && errno == ENOENT;
+
+    if (!file) {
+        return false;
+    }
+
+    char magic[32];
+    int version;
+    bool ok =
+        fscanf(file, "%31s %d", magic, &version) == 2 &&
+        strcmp(magic, CHECKPOINT_MAGIC) == 0 &&
+        version == CHECKPOINT_VERSION &&
+        fscanf(file, " population %d", &self->population) == 1 &&
+        fscanf(file, " games %d", &self->games) == 1 &&
+        fscanf(
+            file, " scoring %d %d %d", &self->scoring.row_deleted,
+            &self->scoring.landed, &self->scoring.move
+        ) == 3 &&
+        fscanf(file, " generation %d", &self->generation) == 1 &&
+        fscanf(file, " sigma %lf", &self->sigma) == 1 &&
+        read_vector(file, "mean", self->mean) &&
+        read_vector(file, "variances", self->variances) &&
+        read_vector(file, "sigma_path", self->sigma_path) &&
+        read_vector(file, "variance_path", self->variance_path) &&
+        fscanf(
+            file, " rng %u %u %u %u", &self->rng.s[0], &self->rng.s[1],
+            &self->rng.s[2], &self->rng.s[3]
+        ) == 4 &&
+        fscanf(file, " best_fitness %lf", &self->best_fitness) == 1 &&
+        read_vector(file, "best", self->best);
+
+    fclose(file);
+
+    return ok;
+}
+
+static bool same_settings(
+    const struct Search *self, const struct Options *options
+) {
+    return self->population == options->population &&
+           self->games == options->games &&
+           self->scoring.row_deleted == options->scoring.row_deleted &&
+           self->scoring.landed == options->scoring.landed &&
+           self->scoring.move == options->scoring.move;
+}
+
+static void play(void *ctx, int index, int worker) {
+    (void)worker;
+
+    struct Evaluation *evaluation = ctx;
+    const struct Options *options = evaluation->options;
+    int candidate = index / options->games;
+    int game = index % options->games;
+
+    struct TetrionConfig config = tetrion_config_default();
+    config.seed = evaluation->seeds[game];
+    config.randomizer = options->randomizer;
+    config.scoring = options->scoring;
+
+    struct Tetrion tetrion;
+    tetrion_init(&tetrion, &config);
+    tetrion_apply(&tetrion, TETRION_ACTION_START);
+
+    struct BotWeights weights = to_weights(evaluation->candidates[candidate]);
+    struct BotPlayer player;
+    bot_player_init(&player, &weights);
+
+    while (tetrion.state != TETRION_STATE_GAME_OVER &&
+           tetrion.time < options->tick_limit) {
+        bot_player_tick(&player, &tetrion);
+    }
+
+    evaluation->scores[index] = tetrion.score;
+}
+
+/* Best first, by the fitness stored in the first element. */
+static int compare_ranks(const void *a, const void *b) {
+    const double *rank_a = a;
+    const double *rank_b = b;
+
+    return (rank_a[0] < rank_b[0]) - (rank_a[0] > rank_b[0]);
+}
+
+/* Moves the distribution towards the best candidates (sorted best first). */
+static void update(
+    struct Search *self, const struct Strategy *strategy,
+    double (*sorted)[DIMENSIONS]
+) {
+    double old_mean[DIMENSIONS];
+    double step[DIMENSIONS];
+    double sigma_path_norm = 0;
+
+    memcpy(old_mean, self->mean, sizeof(old_mean));
+
+    for (int j = 0; j < DIMENSIONS; ++j) {
+        self->mean[j] = 0;
+
+        for (int i = 0; i < strategy->mu; ++i) {
+            self->mean[j] += strategy->weights[i] * sorted[i][j];
+        }
+
+        step[j] = (self->mean[j] - old_mean[j]) / self->sigma;
+    }
+
+    double c_sigma = strategy->c_sigma;
+    double c_c = strategy->c_c;
+
+    for (int j = 0; j < DIMENSIONS; ++j) {
+        self->sigma_path[j] =
+            (1 - c_sigma) * self->sigma_path[j] +
+            sqrt(c_sigma * (2 - c_sigma) * strategy->mu_eff) * step[j] /
+                sqrt(self->variances[j]);
+        sigma_path_norm += self->sigma_path[j] * self->sigma_path[j];
+    }
+
+    sigma_path_norm = sqrt(sigma_path_norm);
+
+    /* Stalls the update of the variance path while the step size grows */
+    double decay = 1 - pow(1 - c_sigma, 2.0 * (self->generation + 1));
+    bool stalled = sigma_path_norm / sqrt(decay) >=
+                   (1.4 + 2.0 / (DIMENSIONS + 1)) * strategy->chi_n;
+
+    for (int j = 0; j < DIMENSIONS; ++j) {
+        double rank_mu = 0;
+
+        self->variance_path[j] =
+            (1 - c_c) * self->variance_path[j] +
+            (stalled ? 0 : sqrt(c_c * (2 - c_c) * strategy->mu_eff) * step[j]);
+
+        for (int i = 0; i < strategy->mu; ++i) {
+            double y = (sorted[i][j] - old_mean[j]) / self->sigma;
+
+            rank_mu += strategy->weights[i] * y * y;
+        }
+
+        self->variances[j] =
+            (1 - strategy->c_1 - strategy->c_mu) * self->variances[j] +
+            strategy->c_1 *
+                (self->variance_path[j] * self->variance_path[j] +
+                 (stalled ? c_c * (2 - c_c) * self->variances[j] : 0)) +
+            strategy->c_mu * rank_mu;
+    }
+
+    self->sigma *= exp(
+        (c_sigma / strategy->d_sigma) * (sigma_path_norm / strategy->chi_n - 1)
+    );
+    ++self->generation;
+}
+
+static void print_vector(const char *name, const double *x) {
+    printf("%s", name);
+
+    for (int i = 0; i < DIMENSIONS; ++i) {
+        printf(" %.6g", x[i]);
+    }
+
+    printf("\n");
+}
+
+int main(int argc, char *argv[]) {
+    struct Options options;
+
+    if (!parse_args(argc, argv, &options)) {
+        usage(argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    struct Search search;
+    bool missing = true;
+
+    if (options.checkpoint &&
+        load_checkpoint(&search, options.checkpoint, &missing)) {
+        if (!same_settings(&search, &options)) {
+            fprintf(
+                stderr,
+                "'%s' was started with -p %d -g %d --score %d,%d,%d\n",
+                options.checkpoint, search.population, search.games,
+                search.scoring.row_deleted, search.scoring.landed,
+                search.scoring.move
+            );
+
+            return EXIT_FAILURE;
+        }
+
+        printf(
+            "resuming from '%s' at generation %d\n", options.checkpoint,
+            search.generation
+        );
+    } else if (missing) {
+        search_init(&search, &options);
+    } else {
+        /* Starting over would overwrite it after the first generation */
+        fprintf(stderr, "cannot load '%s'\n", options.checkpoint);
+
+        return EXIT_FAILURE;
+    }
+
+    struct Strategy strategy;
+    strategy_init(&strategy, options.population);
+
+    size_t games = (size_t)options.population * (size_t)options.games;
+    double (*candidates)[DIMENSIONS] =
+        malloc((size_t)options.population * sizeof(*candidates));
+    /* Candidates sorted by fitness, with the fitness in front */
+    double (*ranks)[DIMENSIONS + 1] =
+        malloc((size_t)options.population * sizeof(*ranks));
+    double (*sorted)[DIMENSIONS] =
+        malloc((size_t)options.population * sizeof(*sorted));
+    struct Evaluation evaluation = {
+        .options = &options,
+        .candidates = candidates,
+        .seeds = malloc((size_t)options.games * sizeof(uint64_t)),
+        .scores = malloc(games * sizeof(double)),
+    };
+
+    struct Pool pool;
+    bool allocated = candidates && ranks && sorted && evaluation.seeds &&
+                     evaluation.scores;
+    bool started = allocated && pool_init(&pool, options.threads);
+    bool ok = started;
+
+    if (!allocated) {
+        fprintf(stderr, "out of memory\n");
+    } else if (!started) {
+        fprintf(stderr, "cannot start the worker threads\n");
+    }
+
+    while (ok && search.generation < options.generations) {
+        /* All candidates play the same games, so they're compared fairly */
+        for (int i = 0; i < options.games; ++i) {
+            evaluation.seeds[i] = rng_next64(&search.rng);
+        }
+
+        for (int i = 0; i < options.population; ++i) {
+            for (int j = 0; j < DIMENSIONS; ++j) {
+                candidates[i][j] = search.mean[j] +
+                                   search.sigma * sqrt(search.variances[j]) *
+                                       gaussian(&search.rng);
+            }
+        }
+
+        pool_run(&pool, (int)games, play, &evaluation);
+
+        double mean_fitness = 0;
+
+        for (int i = 0; i < options.population; ++i) {
+            double fitness = 0;
+
+            for (int j = 0; j < options.games; ++j) {
+                fitness += evaluation.scores[i * options.games + j];
+            }
+
+            fitness /= options.games;
+            mean_fitness += fitness / options.population;
+            ranks[i][0] = fitness;
+            memcpy(&ranks[i][1], candidates[i], sizeof(candidates[i]));
+        }
+
+        qsort(ranks, (size_t)options.population, sizeof(*ranks), compare_ranks);
+
+        for (int i = 0; i < options.population; ++i) {
+            memcpy(sorted[i], &ranks[i][1], sizeof(sorted[i]));
+        }
+
+        if (ranks[0][0] > search.best_fitness) {
+            search.best_fitness = ranks[0][0];
+            memcpy(search.best, sorted[0], sizeof(search.best));
+        }
+
+        update(&search, &strategy, sorted);
+
+        printf(
+            "generation %d: best %.1f, mean %.1f, sigma %.4g\n",
+            search.generation, ranks[0][0], mean_fitness, search.sigma
+        );
+        print_vector("  mean", search.mean);
+        fflush(stdout);
+
+        if (options.checkpoint &&
+            !save_checkpoint(&search, options.checkpoint)) {
+            fprintf(stderr, "cannot save '%s'\n", options.checkpoint);
+            ok = false;
+        }
+    }
+
+    if (started) {
+        printf("best fitness %.1f\n", search.best_fitness);
+        print_vector("best", search.best);
+        pool_deinit(&pool);
+    }
+
+    free(candidates);
+    free(ranks);
+    free(sorted);
+    free(evaluation.seeds);
+    free(evaluation.scores);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,371 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+/*
+ * Plays a versus match between two peers in one process, connected over UDP on
+ * the loopback, with random inputs and a simulated bad link (--latency and
+ * --jitter in frames, --loss in percent). With --bots the first players are
+ * played by the bot instead, so rows get deleted and garbage is exchanged.
+ * Once both peers have all the inputs, their matches must be identical to each
+ * other and to the match simulated straight from the inputs, otherwise the
+ * rollback went wrong. Prints the rollbacks and how long they took.
+ */
+
+#include <wetris/bot.h>
+#include <wetris/netplay.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DEFAULT_FRAMES 3600
+#define BENCH_ROLLBACKS 10000
+
+struct Options {
+    uint64_t frames;
+    uint64_t seed;
+    uint16_t port;
+    int bots;
+    struct NetplayLink link;
+};
+
+/* Follows the placements of the bot with one input a frame. */
+struct Bot {
+    struct BotWeights weights;
+    struct BotPlacement plan;
+    int next_input; /* -1 when a new plan is needed */
+    bool falling;   /* waiting for the piece to fall by one row */
+    int fall_y;
+};
+
+static void usage(const char *name) {
+    fprintf(
+        stderr,
+        "usage: %s [-f FRAMES] [-s SEED] [-p PORT] [--latency FRAMES] "
+        "[--jitter FRAMES] [--loss PERCENT] [--bots COUNT]\n",
+        name
+    );
+}
+
+static bool parse_args(int argc, char *argv[], struct Options *options) {
+    options->frames = DEFAULT_FRAMES;
+    options->seed = (uint64_t)time(NULL);
+    options->port = NETPLAY_DEFAULT_PORT;
+    options->bots = 0;
+    memset(&options->link, 0, sizeof(options->link));
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            options->frames = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            options->seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            options->port = (uint16_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--latency") == 0 && i + 1 < argc) {
+            options->link.latency = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--jitter") == 0 && i + 1 < argc) {
+            options->link.jitter = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--loss") == 0 && i + 1 < argc) {
+            options->link.loss = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--bots") == 0 && i + 1 < argc) {
+            options->bots = atoi(argv[++i]);
+        } else {
+            return false;
+        }
+    }
+
+    return options->frames > 0 && options->port > 0 &&
+           options->link.latency >= 0 && options->link.jitter >= 0 &&
+           options->link.loss >= 0 && options->link.loss < 100 &&
+           options->bots >= 0 && options->bots <= VERSUS_PLAYERS;
+}
+
+static double now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* A few presses a second, like a hurried player. */
+static uint8_t random_input(struct Rng *rng) {
+    static const enum TetrionAction actions[] = {
+        TETRION_ACTION_MOVE_LEFT,  TETRION_ACTION_MOVE_RIGHT,
+        TETRION_ACTION_MOVE_LEFT,  TETRION_ACTION_MOVE_RIGHT,
+        TETRION_ACTION_ROTATE,     TETRION_ACTION_ROTATE_CNT,
+        TETRION_ACTION_HARD_DROP,
+    };
+
+    if (rng_range(rng, 100) >= 15) {
+        return 0;
+    }
+
+    uint32_t count = (uint32_t)(sizeof(actions) / sizeof(actions[0]));
+
+    return VERSUS_INPUT(actions[rng_range(rng, count)]);
+}
+
+static void bot_init(struct Bot *self) {
+    self->weights = bot_weights_default();
+    self->next_input = -1;
+    self->falling = false;
+    self->fall_y = 0;
+}
+
+static bool same_piece(const struct Piece *a, const struct Piece *b) {
+    return a->id == b->id && a->rotation == b->rotation &&
+           a->pos.x == b->pos.x && a->pos.y == b->pos.y;
+}
+
+/*
+ * Like bot_player_tick(), but the inputs of the plan are spread over frames,
+ * since an input of the match holds each action once.
+ */
+static uint8_t bot_input(struct Bot *self, const struct Tetrion *tetrion) {
+    if (tetrion->state != TETRION_STATE_NORMAL) {
+        return 0;
+    }
+
+    if (self->falling) {
+        if (tetrion->piece.pos.y == self->fall_y) {
+            return 0;
+        }
+
+        self->falling = false;
+
+        return VERSUS_INPUT(TETRION_ACTION_SOFT_DROP_OFF);
+    }
+
+    if (self->next_input == self->plan.input_count) {
+        /* The dropped piece hasn't been locked yet */
+        if (same_piece(&tetrion->piece, &self->plan.piece)) {
+            return 0;
+        }
+
+        self->next_input = -1;
+    }
+
+    if (self->next_input < 0) {
+        if (!bot_search(tetrion, &self->weights, NULL, &self->plan)) {
+            return 0;
+        }
+
+        self->next_input = 0;
+    }
+
+    enum TetrionAction input = self->plan.inputs[self->next_input++];
+
+    if (input == TETRION_ACTION_SOFT_DROP_ON) {
+        self->falling = true;
+        self->fall_y = tetrion->piece.pos.y;
+    }
+
+    return VERSUS_INPUT(input);
+}
+
+static bool settled(const struct Netplay *peer, uint64_t frames) {
+    const struct Rollback *rollback = &peer->rollback;
+
+    return peer->state == NETPLAY_STATE_PLAYING &&
+           rollback->versus.frame == frames &&
+           rollback->remote_frames >= frames;
+}
+
+/* The worst case: restoring and playing the longest rollback possible. */
+static double bench_rollback(uint64_t seed) {
+    struct Versus versus;
+    struct VersusSnapshot start;
+    struct VersusSnapshot snapshot;
+    uint8_t inputs[VERSUS_PLAYERS] = {0};
+    struct Rng rng;
+
+    rng_seed(&rng, seed);
+    versus_init(&versus, seed);
+
+    for (int i = 0; i < DEFAULT_FRAMES / 2; ++i) {
+        inputs[0] = random_input(&rng);
+        inputs[1] = random_input(&rng);
+        versus_step(&versus, inputs);
+    }
+
+    versus_snapshot(&versus, &start);
+
+    double start_time = now();
+
+    for (int i = 0; i < BENCH_ROLLBACKS; ++i) {
+        versus_restore(&versus, &start);
+
+        for (int frame = 0; frame < ROLLBACK_MAX_FRAMES; ++frame) {
+            versus_snapshot(&versus, &snapshot);
+            inputs[0] = random_input(&rng);
+            inputs[1] = random_input(&rng);
+            versus_step(&versus, inputs);
+        }
+    }
+
+    return (now() - start_time) / BENCH_ROLLBACKS;
+}
+
+static void print_peer(const char *name, const struct Netplay *peer) {
+    const struct Rollback *rollback = &peer->rollback;
+    double average = rollback->rollbacks
+                         ? (double)rollback->rollback_ns /
+                               (double)rollback->rollbacks / 1e3
+                         : 0.0;
+
+    printf(
+        "%s: %llu rollbacks (%llu frames, at most %d), %.1f us per "
+        "rollback (at most %.1f), %llu stalls, %llu packets sent, %llu lost\n",
+        name, (unsigned long long)rollback->rollbacks,
+        (unsigned long long)rollback->resimulated, rollback->max_depth, average,
+        (double)rollback->max_rollback_ns / 1e3,
+        (unsigned long long)rollback->stalls, (unsigned long long)peer->sent,
+        (unsigned long long)peer->dropped
+    );
+}
+
+int main(int argc, char *argv[]) {
+    struct Options options;
+
+    if (!parse_args(argc, argv, &options)) {
+        usage(argv[0]);
+
+        return EXIT_FAILURE;
+    }
+
+    struct Netplay *peers = malloc(VERSUS_PLAYERS * sizeof(*peers));
+    uint8_t *inputs = malloc(VERSUS_PLAYERS * options.frames);
+    struct NetAddress host = {.host = 0x7f000001, .port = options.port};
+
+    if (!peers || !inputs) {
+        fprintf(stderr, "out of memory\n");
+
+        return EXIT_FAILURE;
+    }
+
+    if (!netplay_host(&peers[0], options.port, options.seed, &options.link)) {
+        fprintf(stderr, "cannot listen on port %u\n", options.port);
+
+        return EXIT_FAILURE;
+    }
+
+    if (!netplay_join(&peers[1], &host, &options.link)) {
+        fprintf(stderr, "cannot open a socket\n");
+
+        return EXIT_FAILURE;
+    }
+
+    /*
+     * Each player presses the same keys whenever its frames run. The inputs
+     * of the bots depend on the match, so it's simulated straight from the
+     * inputs as they're chosen.
+     */
+    struct Versus reference;
+    struct Rng rngs[VERSUS_PLAYERS];
+    struct Bot bots[VERSUS_PLAYERS];
+
+    versus_init(&reference, options.seed);
+
+    struct Rng garbage_rng = reference.rng;
+
+    for (int i = 0; i < VERSUS_PLAYERS; ++i) {
+        rng_seed(&rngs[i], options.seed + (uint64_t)i + 1);
+        bot_init(&bots[i]);
+    }
+
+    for (uint64_t frame = 0; frame < options.frames; ++frame) {
+        uint8_t frame_inputs[VERSUS_PLAYERS];
+
+        for (int i = 0; i < VERSUS_PLAYERS; ++i) {
+            frame_inputs[i] =
+                i < options.bots ? bot_input(&bots[i], &reference.players[i])
+                                 : random_input(&rngs[i]);
+            inputs[(size_t)i * options.frames + frame] = frame_inputs[i];
+        }
+
+        versus_step(&reference, frame_inputs);
+    }
+
+    /* The holes of the garbage are drawn from it, it moves with garbage only */
+    bool garbage =
+        memcmp(&garbage_rng, &reference.rng, sizeof(garbage_rng)) != 0;
+
+    /* Anything beyond the latency and some retransmissions means a hang */
+    uint64_t limit =
+        options.frames * 4 +
+        (uint64_t)(options.link.latency + options.link.jitter + 10) * 1000;
+    uint64_t updates = 0;
+    double start_time = now();
+
+    while (!settled(&peers[0], options.frames) ||
+           !settled(&peers[1], options.frames)) {
+        if (updates++ == limit) {
+            fprintf(stderr, "the match got stuck\n");
+
+            return EXIT_FAILURE;
+        }
+
+        for (int i = 0; i < VERSUS_PLAYERS; ++i) {
+            uint64_t frame = peers[i].rollback.versus.frame;
+            const uint8_t *input =
+                frame < options.frames
+                    ? &inputs[(size_t)i * options.frames + frame]
+                    : NULL;
+
+            netplay_update(&peers[i], input);
+        }
+    }
+
+    double elapsed = now() - start_time;
+    struct VersusSnapshot snapshots[VERSUS_PLAYERS + 1];
+
+    for (int i = 0; i < VERSUS_PLAYERS; ++i) {
+        rollback_resimulate(&peers[i].rollback);
+        versus_snapshot(&peers[i].rollback.versus, &snapshots[i]);
+    }
+
+    versus_snapshot(&reference, &snapshots[VERSUS_PLAYERS]);
+
+    bool in_sync = memcmp(&snapshots[0], &snapshots[1], sizeof(snapshots[0])) ==
+                       0 &&
+                   memcmp(
+                       &snapshots[0], &snapshots[VERSUS_PLAYERS],
+                       sizeof(snapshots[0])
+                   ) == 0;
+
+    printf(
+        "%llu frames in %llu updates, %.3f s, scores %d and %d, %d and %d "
+        "rows deleted%s\n",
+        (unsigned long long)options.frames, (unsigned long long)updates,
+        elapsed, reference.players[0].score, reference.players[1].score,
+        reference.players[0].lines, reference.players[1].lines,
+        garbage ? ", garbage exchanged" : ""
+    );
+    print_peer("host", &peers[0]);
+    print_peer("join", &peers[1]);
+    printf(
+        "rollback of %d frames: %.1f us\n", ROLLBACK_MAX_FRAMES,
+        bench_rollback(options.seed) * 1e6
+    );
+    printf(in_sync ? "in sync\n" : "out of sync\n");
+
+    /* Without garbage the bots would leave a part of the match untested */
+    bool ok = in_sync && (options.bots == 0 || garbage);
+
+    if (!garbage && options.bots > 0) {
+        fprintf(stderr, "the bots sent no garbage\n");
+    }
+
+    for (int i = 0; i < VERSUS_PLAYERS; ++i) {
+        netplay_deinit(&peers[i]);
+    }
+
+    free(inputs);
+    free(peers);
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#include <wetris/trans_table.h>
+
+#include <stdlib.h>
+
+#define MEGABYTE ((size_t)1 << 20)
+
+/* Keeps an empty entry (all zeros) from matching the key 0 */
+#define KEY_TAG 1u
+
+/* The counter slot of the thread, assigned on its first use of any table */
+static _Thread_local int t_slot = -1;
+static _Atomic int g_next_slot;
+
+static struct TransCounters *thread_counters(struct TransTable *self) {
+    if (t_slot < 0) {
+        int next =
+            atomic_fetch_add_explicit(&g_next_slot, 1, memory_order_relaxed);
+
+        t_slot = next % TRANS_TABLE_COUNTER_SLOTS;
+    }
+
+    return &self->counters[t_slot];
+}
+
+static struct TransEntry *find_entry(
+    const struct TransTable *self, uint64_t key
+) {
+    return &self->entries[key & self->mask];
+}
+
+bool trans_table_init(struct TransTable *self, size_t megabytes) {
+    size_t count = megabytes * MEGABYTE / sizeof(struct TransEntry);
+
+    self->entries = NULL;
+    self->mask = 0;
+
+    if (count == 0) {
+        return false;
+    }
+
+    /* Rounds down to a power of two */
+    while (count & (count - 1)) {
+        count &= count - 1;
+    }
+
+    self->entries = malloc(count * sizeof(struct TransEntry));
+
+    if (!self->entries) {
+        return false;
+    }
+
+    self->mask = count - 1;
+    trans_table_clear(self);
+
+    return true;
+}
+
+void trans_table_deinit(struct TransTable *self) {
+    free(self->entries);
+    self->entries = NULL;
+}
+
+void trans_table_clear(struct TransTable *self) {
+    for (size_t i = 0; i <= self->mask; ++i) {
+        atomic_store_explicit(&self->entries[i].check, 0, memory_order_relaxed);
+        atomic_store_explicit(&self->entries[i].value, 0, memory_order_relaxed);
+    }
+
+    for (int i = 0; i < TRANS_TABLE_COUNTER_SLOTS; ++i) {
+        atomic_store(&self->counters[i].probes, 0);
+        atomic_store(&self->counters[i].hits, 0);
+        atomic_store(&self->counters[i].stores, 0);
+    }
+}
+
+bool trans_table_probe(struct TransTable *self, uint64_t key, uint64_t *value) {
+    struct TransEntry *entry = find_entry(self, key);
+    uint64_t check = atomic_load_explicit(&entry->check, memory_order_relaxed);
+    uint64_t stored = atomic_load_explicit(&entry->value, memory_order_relaxed);
+    struct TransCounters *counters = thread_counters(self);
+
+    atomic_fetch_add_explicit(&counters->probes, 1, memory_order_relaxed);
+
+    if ((check ^ stored) != (key | KEY_TAG)) {
+        return false;
+    }
+
+    atomic_fetch_add_explicit(&counters->hits, 1, memory_order_relaxed);
+    *value = stored;
+
+    return true;
+}
+
+void trans_table_store(struct TransTable *self, uint64_t key, uint64_t value) {
+    struct TransEntry *entry = find_entry(self, key);
+
+    atomic_store_explicit(
+        &entry->check, (key | KEY_TAG) ^ value, memory_order_relaxed
+    );
+    atomic_store_explicit(&entry->value, value, memory_order_relaxed);
+    atomic_fetch_add_explicit(
+        &thread_counters(self)->stores, 1, memory_order_relaxed
+    );
+}
+
+void trans_table_stats(
+    const struct TransTable *self, struct TransTableStats *stats
+) {
+    stats->probes = 0;
+    stats->hits = 0;
+    stats->stores = 0;
+
+    for (int i = 0; i < TRANS_TABLE_COUNTER_SLOTS; ++i) {
+        const struct TransCounters *counters = &self->counters[i];
+
+        stats->probes +=
+            atomic_load_explicit(&counters->probes, memory_order_relaxed);
+        stats->hits +=
+            atomic_load_explicit(&counters->hits, memory_order_relaxed);
+        stats->stores +=
+            atomic_load_explicit(&counters->stores, memory_order_relaxed);
+    }
+}
+
+double trans_table_hit_rate(const struct TransTable *self) {
+    struct TransTableStats stats;
+    trans_table_stats(self, &stats);
+
+    return stats.probes ? (double)stats.hits / (double)stats.probes : 0.0;
+}
@@ -9,6 +9,18 @@
 #include <wetris/game.h>
 
 #define OUTER_SPACING 16
+#define PREVIEW_SPACING (TILE_HEIGHT * 3) /* pieces are at most 2 tiles high */
+
+static void layout_stats(struct UiState *self) {
+    struct Text *stats = &self->texts[TEXT_STATS];
+
+    text_set(stats, "SCORE\n%d\n\nLEVEL\n%d", self->score, self->level);
+
+    stats->rect.x =
+        self->game->width - TETRION_PADDING_RIGHT / 2 - stats->rect.w / 2;
+    stats->rect.y = OUTER_SPACING;
+    self->stats_dirty = false;
+}
 
 void ui_init(struct UiState *self, struct Game *game) {
     const struct SDL_Color WHITE = {0xff, 0xff, 0xff, 0xff};
@@ -22,12 +34,16 @@ void ui_init(struct UiState *self, struct Game *game) {
     struct Text *copyright = &self->texts[TEXT_COPYRIGHT];
 
     self->game = game;
+    self->dirty = true;
 
     text_init(
         stats, &game->font_store.fonts[FONT_BIG], TEXT_ALIGN_RIGHT, WHITE
     );
 
-    ui_set_stats(self, 0, 1);
+    self->score = 0;
+    self->level = 1;
+    /* The preview is placed below */
+    layout_stats(self);
 
     text_init(
         paused, &game->font_store.fonts[FONT_LARGE], TEXT_ALIGN_LEFT, WHITE
@@ -87,11 +103,13 @@ void ui_init(struct UiState *self, struct Game *game) {
     copyright->fg = LIGHT_GRAY;
     copyright->show = true;
 
-    self->next_piece_pos.x = self->game->width - TETRION_PADDING_RIGHT / 2 -
-                             (PIECE_WIDTH * TILE_WIDTH) / 2;
-    self->next_piece_pos.y = 16 + TILE_HEIGHT + self->texts[TEXT_STATS].rect.h;
+    self->preview_pos.x = self->game->width - TETRION_PADDING_RIGHT / 2 -
+                          (PIECE_WIDTH * TILE_WIDTH) / 2;
+    self->preview_pos.y = 16 + TILE_HEIGHT + self->texts[TEXT_STATS].rect.h;
+
+    struct Tetrion *tetrion = game_tetrion(game);
 
-    ui_set_next_piece(self, &game->tetrion.next_piece);
+    ui_set_preview(self, tetrion->preview, tetrion->config.preview);
 }
 
 void ui_deinit(struct UiState *self) {
@@ -105,34 +123,61 @@ void ui_deinit(struct UiState *self) {
 }
 
 void ui_set_stats(struct UiState *self, int score, int level) {
-    struct Text *stats = &self->texts[TEXT_STATS];
-
-    text_set(stats, "SCORE\n%d\n\nLEVEL\n%d", score, level);
+    if (score == self->score && level == self->level) {
+        return;
+    }
 
-    stats->rect.x =
-        self->game->width - TETRION_PADDING_RIGHT / 2 - stats->rect.w / 2;
-    stats->rect.y = OUTER_SPACING;
+    self->score = score;
+    self->level = level;
+    self->stats_dirty = true;
+    self->dirty = true;
 }
 
-void ui_set_next_piece(struct UiState *self, const struct Piece *piece) {
-    self->next_piece = *piece;
+void ui_set_preview(
+    struct UiState *self, const struct Piece *pieces, int count
+) {
+    for (int i = 0; i < count; ++i) {
+        self->preview[i] = pieces[i];
+    }
+
+    self->preview_count = count;
+    self->dirty = true;
 }
 
 void ui_show_text(struct UiState *self, enum TextId id) {
+    self->dirty |= !self->texts[id].show;
     self->texts[id].show = true;
 }
 
 void ui_hide_text(struct UiState *self, enum TextId id) {
+    self->dirty |= self->texts[id].show;
     self->texts[id].show = false;
 }
 
-void ui_render(struct UiState *self) {
+void ui_render(struct UiState *self, struct TileBatch *batch) {
+    self->dirty = false;
+
+    if (self->stats_dirty) {
+        layout_stats(self);
+    }
+
     for (int i = 0; i < TOTAL_TEXTS; ++i) {
         text_render(&self->texts[i]);
     }
 
-    piece_render(
-        &self->next_piece, self->game->renderer, &self->game->tileset,
-        self->next_piece_pos
-    );
+    /* The pieces which would overlap the copyright aren't shown */
+    int bottom = self->texts[TEXT_COPYRIGHT].rect.y;
+
+    for (int i = 0; i < self->preview_count; ++i) {
+        int y = self->preview_pos.y + i * PREVIEW_SPACING;
+
+        if (y + PREVIEW_SPACING > bottom) {
+            break;
+        }
+
+        tileset_batch_piece(
+            &self->game->tileset, batch, self->game->renderer,
+            &self->preview[i], self->preview_pos.x, y
+        );
+    }
 }
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#include <wetris/versus.h>
+
+#include <string.h>
+
+/* Garbage rows sent for deleting 0, 1, 2, 3 and 4 rows at once */
+static const int g_garbage[] = {0, 0, 1, 2, 4};
+
+static int garbage_for(int deleted) {
+    int max = (int)(sizeof(g_garbage) / sizeof(g_garbage[0])) - 1;
+
+    return g_garbage[deleted < max ? deleted : max];
+}
+
+void versus_init(struct Versus *self, uint64_t seed) {
+    struct TetrionConfig config = tetrion_config_default();
+
+    config.seed = seed;
+    config.randomizer = RANDOMIZER_BAG;
+    config.tick_rate = VERSUS_FRAME_RATE;
+
+    for (int i = 0; i < VERSUS_PLAYERS; ++i) {
+        tetrion_init(&self->players[i], &config);
+        tetrion_apply(&self->players[i], TETRION_ACTION_START);
+        self->lines[i] = 0;
+    }
+
+    rng_seed(&self->rng, ~seed);
+    self->frame = 0;
+}
+
+void versus_step(struct Versus *self, const uint8_t inputs[VERSUS_PLAYERS]) {
+    int garbage[VERSUS_PLAYERS];
+
+    for (int i = 0; i < VERSUS_PLAYERS; ++i) {
+        struct Tetrion *player = &self->players[i];
+
+        /* START would restart a lost game, the match is over by then */
+        for (int action = TETRION_ACTION_START + 1;
+             action < TOTAL_TETRION_ACTIONS; ++action) {
+            if (inputs[i] & VERSUS_INPUT(action)) {
+                tetrion_apply(player, (enum TetrionAction)action);
+            }
+        }
+
+        tetrion_tick(player);
+        garbage[i] = garbage_for(player->lines - self->lines[i]);
+        self->lines[i] = player->lines;
+    }
+
+    /* Exchanged after both ticked, so the order of the players doesn't
+     * matter */
+    for (int i = 0; i < VERSUS_PLAYERS; ++i) {
+        if (garbage[i] > 0) {
+            int hole = (int)rng_range(&self->rng, BOARD_WIDTH - 2);
+
+            tetrion_add_garbage(
+                &self->players[(i + 1) % VERSUS_PLAYERS], garbage[i], hole
+            );
+        }
+    }
+
+    ++self->frame;
+}
+
+void versus_snapshot(
+    const struct Versus *self, struct VersusSnapshot *snapshot
+) {
+    /* Cleared padding makes equal states compare equal byte by byte */
+    memset(snapshot, 0, sizeof(*snapshot));
+
+    for (int i = 0; i < VERSUS_PLAYERS; ++i) {
+        tetrion_snapshot(&self->players[i], &snapshot->players[i]);
+        snapshot->lines[i] = self->lines[i];
+    }
+
+    snapshot->rng = self->rng;
+    snapshot->frame = self->frame;
+}
+
+void versus_restore(
+    struct Versus *self, const struct VersusSnapshot *snapshot
+) {
+    for (int i = 0; i < VERSUS_PLAYERS; ++i) {
+        tetrion_restore(&self->players[i], &snapshot->players[i]);
+        self->lines[i] = snapshot->lines[i];
+    }
+
+    self->rng = snapshot->rng;
+    self->frame = snapshot->frame;
+}
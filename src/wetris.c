@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2024-present inunix3
+ *
+ * This file is licensed under the MIT License (see LICENSE.md).
+ */
+
+#include <wetris/wetris.h>
+
+#include <wetris/tetrion.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#define SNAPSHOT_MAGIC 0x4e535457u /* "WTSN" */
+#define SNAPSHOT_VERSION 2
+
+_Static_assert(
+    WETRIS_BOARD_WIDTH == BOARD_WIDTH - 2 &&
+        WETRIS_BOARD_HEIGHT == BOARD_HEIGHT - 1,
+    "the public board size is out of date"
+);
+
+/* The tetrion snapshot is stored as is behind a small header. */
+struct SnapshotHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size; /* of the tetrion snapshot */
+};
+
+_Static_assert(
+    sizeof(struct SnapshotHeader) + sizeof(struct TetrionSnapshot) <=
+        WETRIS_SNAPSHOT_SIZE,
+    "snapshots don't fit in WETRIS_SNAPSHOT_SIZE"
+);
+
+struct Wetris {
+    struct Tetrion tetrion;
+
+    uint8_t board[WETRIS_BOARD_SIZE];
+    /* What the board buffer shows, it's only rebuilt when these change */
+    bool board_valid;
+    uint32_t board_generation;
+    struct Piece board_piece;
+};
+
+static const enum TetrionAction g_actions[] = {
+    [WETRIS_ACTION_MOVE_LEFT] = TETRION_ACTION_MOVE_LEFT,
+    [WETRIS_ACTION_MOVE_RIGHT] = TETRION_ACTION_MOVE_RIGHT,
+    [WETRIS_ACTION_ROTATE] = TETRION_ACTION_ROTATE,
+    [WETRIS_ACTION_ROTATE_CNT] = TETRION_ACTION_ROTATE_CNT,
+    [WETRIS_ACTION_SOFT_DROP_ON] = TETRION_ACTION_SOFT_DROP_ON,
+    [WETRIS_ACTION_SOFT_DROP_OFF] = TETRION_ACTION_SOFT_DROP_OFF,
+    [WETRIS_ACTION_HARD_DROP] = TETRION_ACTION_HARD_DROP,
+};
+
+static bool same_piece(const struct Piece *a, const struct Piece *b) {
+    return a->id == b->id && a->rotation == b->rotation &&
+           a->pos.x == b->pos.x && a->pos.y == b->pos.y;
+}
+
+/*
+ * The generation of the tetrion changes with every change of the locked
+ * blocks, restores included, so it tells whether they're still the same.
+ */
+static void update_board(struct Wetris *self) {
+    const struct Board *board = &self->tetrion.board;
+    const struct Piece *piece = &self->tetrion.piece;
+
+    if (self->board_valid &&
+        self->board_generation == self->tetrion.generation &&
+        same_piece(&self->board_piece, piece)) {
+        return;
+    }
+
+    for (int y = 0; y < WETRIS_BOARD_HEIGHT; ++y) {
+        uint32_t colors = board->colors[y];
+
+        for (int x = 0; x < WETRIS_BOARD_WIDTH; ++x) {
+            self->board[y * WETRIS_BOARD_WIDTH + x] =
+                (uint8_t)((colors >> (BOARD_COLOR_BITS * x)) &
+                          BOARD_COLOR_MASK);
+        }
+    }
+
+    for (int py = 0; py < PIECE_HEIGHT; ++py) {
+        for (int px = 0; px < PIECE_WIDTH; ++px) {
+            /* The board coordinates include the left wall */
+            int x = piece->pos.x + px - 1;
+            int y = piece->pos.y + py;
+
+            if (!piece_has_block(piece, px, py) || x < 0 ||
+                x >= WETRIS_BOARD_WIDTH || y < 0 || y >= WETRIS_BOARD_HEIGHT) {
+                continue;
+            }
+
+            self->board[y * WETRIS_BOARD_WIDTH + x] =
+                (uint8_t)((int)piece->id + 1) | WETRIS_CELL_FALLING;
+        }
+    }
+
+    self->board_valid = true;
+    self->board_generation = self->tetrion.generation;
+    self->board_piece = *piece;
+}
+
+/* Nothing reads the events here, they'd only pile up. */
+static void drain_events(struct Wetris *self) {
+    enum TetrionEvent event;
+
+    while (tetrion_poll_event(&self->tetrion, &event)) {
+    }
+}
+
+int wetris_abi_version(void) {
+    return WETRIS_ABI_VERSION;
+}
+
+struct Wetris *wetris_create(uint64_t seed) {
+    struct Wetris *self = malloc(sizeof(*self));
+
+    if (!self) {
+        return NULL;
+    }
+
+    struct TetrionConfig config = tetrion_config_default();
+    config.seed = seed;
+
+    tetrion_init(&self->tetrion, &config);
+    tetrion_apply(&self->tetrion, TETRION_ACTION_START);
+    drain_events(self);
+    self->board_valid = false;
+    update_board(self);
+
+    return self;
+}
+
+void wetris_destroy(struct Wetris *self) {
+    free(self);
+}
+
+void wetris_reset(struct Wetris *self, uint64_t seed) {
+    tetrion_reset(&self->tetrion, seed);
+    tetrion_apply(&self->tetrion, TETRION_ACTION_START);
+    drain_events(self);
+    update_board(self);
+}
+
+int32_t wetris_step(struct Wetris *self, int action) {
+    struct Tetrion *tetrion = &self->tetrion;
+    int score = tetrion->score;
+
+    if (tetrion->state == TETRION_STATE_GAME_OVER) {
+        return 0;
+    }
+
+    if (action > WETRIS_ACTION_NONE && action <= WETRIS_ACTION_HARD_DROP) {
+        tetrion_apply(tetrion, g_actions[action]);
+    }
+
+    tetrion_tick(tetrion);
+    drain_events(self);
+    update_board(self);
+
+    return tetrion->score - score;
+}
+
+const uint8_t *wetris_board(const struct Wetris *self) {
+    return self->board;
+}
+
+void wetris_get_board(const struct Wetris *self, uint8_t *buffer) {
+    memcpy(buffer, self->board, sizeof(self->board));
+}
+
+int32_t wetris_score(const struct Wetris *self) {
+    return self->tetrion.score;
+}
+
+int wetris_level(const struct Wetris *self) {
+    return self->tetrion.level;
+}
+
+uint64_t wetris_time(const struct Wetris *self) {
+    return self->tetrion.time;
+}
+
+bool wetris_game_over(const struct Wetris *self) {
+    return self->tetrion.state == TETRION_STATE_GAME_OVER;
+}
+
+int wetris_piece(const struct Wetris *self) {
+    return (int)self->tetrion.piece.id;
+}
+
+int wetris_next_piece(const struct Wetris *self) {
+    return (int)self->tetrion.preview[0].id;
+}
+
+bool wetris_snapshot(const struct Wetris *self, void *buffer, size_t size) {
+    if (size < WETRIS_SNAPSHOT_SIZE) {
+        return false;
+    }
+
+    struct SnapshotHeader header = {
+        .magic = SNAPSHOT_MAGIC,
+        .version = SNAPSHOT_VERSION,
+        .size = sizeof(struct TetrionSnapshot),
+    };
+    struct TetrionSnapshot snapshot;
+
+    /* No padding bytes with garbage, equal games give equal snapshots */
+    memset(buffer, 0, WETRIS_SNAPSHOT_SIZE);
+    memset(&snapshot, 0, sizeof(snapshot));
+    tetrion_snapshot(&self->tetrion, &snapshot);
+
+    memcpy(buffer, &header, sizeof(header));
+    memcpy((uint8_t *)buffer + sizeof(header), &snapshot, sizeof(snapshot));
+
+    return true;
+}
+
+bool wetris_restore(struct Wetris *self, const void *buffer, size_t size) {
+    struct SnapshotHeader header;
+    struct TetrionSnapshot snapshot;
+
+    if (size < sizeof(header) + sizeof(snapshot)) {
+        return false;
+    }
+
+    memcpy(&header, buffer, sizeof(header));
+    memcpy(
+        &snapshot, (const uint8_t *)buffer + sizeof(header), sizeof(snapshot)
+    );
+
+    if (header.magic != SNAPSHOT_MAGIC || header.version != SNAPSHOT_VERSION ||
+        header.size != sizeof(snapshot) || !tetrion_snapshot_valid(&snapshot)) {
+        return false;
+    }
+
+    tetrion_restore(&self->tetrion, &snapshot);
+    drain_events(self);
+    update_board(self);
+
+    return true;
+}